@@ -0,0 +1,338 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+// Microbenchmarks of CPU side hot paths, doesn't create a GL context.
+
+// clang-format off
+#include "text.h"
+#include "balls.h"
+#include "cull.h"
+#include "occlusion.h"
+#include "indices.h"
+#include "sphere.h"
+#include "controls.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+// clang-format on
+
+namespace {
+// Total bytes requested from the global allocator by this process
+std::atomic<uint64_t> AllocatedBytes(0);
+} // namespace
+
+void *operator new(size_t Size) {
+  AllocatedBytes.fetch_add(Size, std::memory_order_relaxed);
+  if (void *Ptr = std::malloc(Size ? Size : 1)) {
+    return Ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t Size) { return operator new(Size); }
+void operator delete(void *Ptr) noexcept { std::free(Ptr); }
+void operator delete[](void *Ptr) noexcept { std::free(Ptr); }
+void operator delete(void *Ptr, size_t) noexcept { std::free(Ptr); }
+void operator delete[](void *Ptr, size_t) noexcept { std::free(Ptr); }
+
+namespace {
+using benchClock = std::chrono::steady_clock;
+
+// Prevent the compiler from optimizing away a computed value
+template <typename T> void doNotOptimize(const T &Value) {
+  asm volatile("" : : "r,m"(Value) : "memory");
+}
+
+struct benchResult {
+  std::string Name;
+  uint64_t Iterations;
+  double NsPerOp;
+  double BytesPerOp;
+  double VerticesPerSec;
+};
+
+// Runs Op in batches of doubling size until a batch takes at least MinTime
+// seconds, and reports the measurements of the final batch.
+template <typename Fn>
+benchResult runBench(const std::string &Name, double VerticesPerOp,
+                     double MinTime, Fn &&Op) {
+  uint64_t Iterations = 1;
+  while (true) {
+    uint64_t AllocStart = AllocatedBytes.load();
+    auto Start = benchClock::now();
+    for (uint64_t i = 0; i < Iterations; i++) {
+      Op();
+    }
+    std::chrono::duration<double> Elapsed = benchClock::now() - Start;
+    uint64_t Allocated = AllocatedBytes.load() - AllocStart;
+
+    if (Elapsed.count() >= MinTime || Iterations >= (1ull << 32)) {
+      double Seconds = Elapsed.count();
+      return {Name, Iterations, (Seconds * 1.0e9) / Iterations,
+              static_cast<double>(Allocated) / Iterations,
+              (VerticesPerOp * Iterations) / Seconds};
+    }
+    Iterations *= 2;
+  }
+}
+
+void printHeader() {
+  std::cout << std::left << std::setw(36) << "benchmark" << std::right
+            << std::setw(12) << "iterations" << std::setw(16) << "ns/op"
+            << std::setw(16) << "bytes/op" << std::setw(16) << "vertices/s"
+            << std::endl;
+}
+
+void printResult(const benchResult &R) {
+  std::cout << std::left << std::setw(36) << R.Name << std::right
+            << std::setw(12) << R.Iterations << std::fixed
+            << std::setprecision(1) << std::setw(16) << R.NsPerOp
+            << std::setw(16) << R.BytesPerOp << std::scientific
+            << std::setprecision(3) << std::setw(16);
+  if (R.VerticesPerSec > 0.0) {
+    std::cout << R.VerticesPerSec;
+  } else {
+    std::cout << "-";
+  }
+  std::cout << std::defaultfloat << std::endl;
+}
+
+void benchSphere(unsigned MaxStacks, double MinTime) {
+  struct tessellation {
+    unsigned Stacks;
+    unsigned Sectors;
+  };
+  const tessellation Sweep[] = {
+      {18, 36}, {64, 128}, {256, 512}, {1024, 2048}, {4096, 8192}};
+
+  for (const tessellation &T : Sweep) {
+    if (T.Stacks > MaxStacks) {
+      break;
+    }
+
+    // Constructing a sphere runs buildVertices()
+    double Vertices = (T.Stacks + 1.0) * (T.Sectors + 1.0);
+    std::string Name = "sphere::buildVertices " + std::to_string(T.Stacks) +
+                       "x" + std::to_string(T.Sectors);
+    printResult(runBench(Name, Vertices, MinTime, [&]() {
+      sphere Sphere(1.0f, T.Sectors, T.Stacks);
+      doNotOptimize(Sphere.getVertexData());
+    }));
+  }
+}
+
+void benchMeshes(double MinTime) {
+  // Icosphere and cube-sphere matched to the triangles of a 256x512 UV sphere
+  for (meshType Mesh : {meshType::Ico, meshType::Cube}) {
+    sphere Reference(1.0f, 512, 256, Mesh);
+    const double Vertices = Reference.getNumVertices();
+    std::string Name = "sphere " + Reference.getDescription();
+    printResult(runBench(Name, Vertices, MinTime, [&]() {
+      sphere Sphere(1.0f, 512, 256, Mesh);
+      doNotOptimize(Sphere.getVertexData());
+    }));
+  }
+}
+
+void benchBalls(double MinTime) {
+  for (unsigned NumBalls : {1000u, 1000000u}) {
+    std::string Name = "buildBalls " + std::to_string(NumBalls);
+    printResult(runBench(Name, 0.0, MinTime, [&]() {
+      std::vector<ballInstance> Balls = buildBalls(NumBalls);
+      doNotOptimize(Balls.data());
+    }));
+  }
+}
+
+void benchCull(double MinTime) {
+  // The default camera sees roughly a third of the grid
+  controls Controls(nullptr, 1024, 768);
+  Controls.refreshMatrices();
+  const glm::mat4 Clip = Controls.getMVPMatrix(glm::mat4(1.f), false);
+  const unsigned NumBalls = 1000000;
+  ballCuller Culler(buildBalls(NumBalls), 1.0f);
+  std::vector<ballInstance> Visible(NumBalls);
+
+  const unsigned MaxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned Threads = 1; Threads <= MaxThreads; Threads *= 2) {
+    workerPool Pool(Threads);
+    std::string Name = "ballCuller::cull 1000000 " + std::to_string(Threads) +
+                       (Threads == 1 ? " thread" : " threads");
+    printResult(runBench(Name, 0.0, MinTime, [&]() {
+      doNotOptimize(Culler.cull(Clip, Pool, Visible.data()));
+    }));
+  }
+}
+
+void benchOcclusion(double MinTime) {
+  controls Controls(nullptr, 1024, 768);
+  Controls.refreshMatrices();
+  const glm::mat4 Clip = Controls.getMVPMatrix(glm::mat4(1.f), false);
+  const unsigned NumBalls = 100000;
+  ballCuller Culler(buildBalls(NumBalls), 1.0f);
+  std::vector<ballInstance> InView(NumBalls), Visible(NumBalls);
+  workerPool Pool;
+  const size_t NumInView = Culler.cull(Clip, Pool, InView.data());
+
+  // Depth buffer a quarter of the window, as glsphere uses
+  occlusionCuller Occluder(256, 192);
+  const size_t NumVisible = Occluder.cull(
+      InView.data(), NumInView, 1.0f, Controls.getViewMatrix(),
+      Controls.getProjectionMatrix(), Pool, Visible.data());
+  // Balls in view, and of those left visible
+  std::string Name = "occlusionCuller::cull " + std::to_string(NumInView) +
+                     " -> " + std::to_string(NumVisible);
+  printResult(runBench(Name, 0.0, MinTime, [&]() {
+    doNotOptimize(Occluder.cull(InView.data(), NumInView, 1.0f,
+                                Controls.getViewMatrix(),
+                                Controls.getProjectionMatrix(), Pool,
+                                Visible.data()));
+  }));
+}
+
+void benchIndices(double MinTime) {
+  sphere Sphere(1.0f, 512, 256);
+  const double Vertices = Sphere.getNumVertices();
+  printResult(runBench("buildIndexBuffer list 256x512", Vertices, MinTime,
+                       [&]() {
+                         indexBuffer Buffer = buildIndexBuffer(
+                             Sphere.getIndices(), Sphere.getNumVertices(),
+                             GL_TRIANGLES);
+                         doNotOptimize(Buffer.getData());
+                       }));
+  printResult(runBench("buildIndexBuffer strip 256x512", Vertices, MinTime,
+                       [&]() {
+                         indexBuffer Buffer = buildIndexBuffer(
+                             Sphere.getStripIndices(),
+                             Sphere.getNumVertices(), GL_TRIANGLE_STRIP);
+                         doNotOptimize(Buffer.getData());
+                       }));
+}
+
+void benchMVP(double MinTime) {
+  // Without a window the matrices hold their initial values
+  controls Controls(nullptr, 1024, 768);
+
+  glm::mat4 Model(1.f);
+  printResult(runBench("controls::getMVPMatrix", 0.0, MinTime, [&]() {
+    glm::mat4 MVP = Controls.getMVPMatrix(Model, false);
+    doNotOptimize(MVP);
+    // Feed the result back so iterations can't be hoisted
+    Model[3][0] = MVP[3][0] * 1.0e-9f;
+  }));
+  printResult(
+      runBench("controls::getMVPMatrix rotation", 0.0, MinTime, [&]() {
+        glm::mat4 MVP = Controls.getMVPMatrix(Model, true);
+        doNotOptimize(MVP);
+        Model[3][0] = MVP[3][0] * 1.0e-9f;
+      }));
+}
+
+void benchText(double MinTime) {
+  // Metrics approximating FreeSans at 48px
+  std::vector<charInfo> Glyphs(128);
+  for (unsigned i = 0; i < Glyphs.size(); i++) {
+    Glyphs[i] = {glm::vec2(0.0f), glm::vec2(0.05f),
+                 glm::ivec2(20 + i % 8, 34), glm::ivec2(2, 34),
+                 static_cast<unsigned>((26 + i % 4) << 6)};
+  }
+
+  auto Layout = [&](const std::string &Str, float X, float Y) {
+    float Vertices[6][4];
+    for (auto Char : Str) {
+      layoutGlyph(Glyphs[Char & 0x7f], .5f, X, Y, Vertices);
+      doNotOptimize(Vertices);
+    }
+  };
+
+  const std::string StrFPS = "FPS: 144";
+  const std::string StrPos = "Camera Position (0.0312, -1.25, 2.96875)";
+  double Vertices = 6.0 * (StrFPS.size() + StrPos.size());
+  printResult(runBench("text layoutGlyph HUD", Vertices, MinTime, [&]() {
+    Layout(StrFPS, 5.0f, 5.0f);
+    Layout(StrPos, 5.0f, 40.0f);
+  }));
+
+  // ASCII with two and three byte sequences, as in names
+  const std::string StrUTF8 = "Player: J\xc3\xbcrgen M\xc3\xbcller "
+                              "\xe2\x80\x94 Team \xe6\x9d\xb1\xe4\xba\xac";
+  printResult(runBench("text decodeUTF8", 0.0, MinTime, [&]() {
+    char32_t Sum = 0;
+    for (size_t Pos = 0; Pos < StrUTF8.size();) {
+      Sum += decodeUTF8(StrUTF8, Pos);
+    }
+    doNotOptimize(Sum);
+  }));
+
+  // Includes building the strings each frame, as main() does
+  controls Controls(nullptr, 1024, 768);
+  unsigned FPS = 144;
+  printResult(runBench("text HUD strings + layout", Vertices, MinTime, [&]() {
+    std::string Str("FPS: ");
+    Str.append(std::to_string(FPS));
+    Layout(Str, 5.0f, 5.0f);
+    Layout(Controls.getPositionStr(), 5.0f, 40.0f);
+  }));
+
+  // The position label is formatted every frame, into a stack buffer
+  printResult(runBench("controls getPositionStr", 0.0, MinTime, [&]() {
+    doNotOptimize(Controls.getPositionStr());
+  }));
+  printResult(runBench("controls formatPosition", 0.0, MinTime, [&]() {
+    char Buffer[controls::PositionStrSize];
+    doNotOptimize(Controls.formatPosition(Buffer, sizeof(Buffer)));
+    doNotOptimize(Buffer);
+  }));
+}
+
+void printUsage(std::string Name) {
+  std::cout << "Usage: " << Name << std::endl
+            << "Microbenchmarks of GLSphere CPU hot paths." << std::endl
+            << "Options:" << std::endl
+            << "\t-h, --help\t\tShow this help message" << std::endl
+            << "\t--max-stacks N \t\tLargest sphere stacks in the sweep, "
+            << "defaults to 4096" << std::endl
+            << "\t--min-time S \t\tMinimum seconds per benchmark, defaults "
+            << "to 0.5" << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  unsigned MaxStacks = 4096;
+  double MinTime = 0.5;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if ((arg == "-h") || (arg == "--help")) {
+      printUsage(argv[0]);
+      return 0;
+    } else if (arg == "--max-stacks" && i + 1 < argc) {
+      MaxStacks = std::atoi(argv[++i]);
+    } else if (arg == "--min-time" && i + 1 < argc) {
+      MinTime = std::atof(argv[++i]);
+    } else {
+      std::cout << "Error: Unknown CLI argument \"" << arg << "\"" << std::endl;
+      printUsage(argv[0]);
+      return -1;
+    }
+  }
+
+  printHeader();
+  benchSphere(MaxStacks, MinTime);
+  benchMeshes(MinTime);
+  benchIndices(MinTime);
+  benchBalls(MinTime);
+  benchCull(MinTime);
+  benchOcclusion(MinTime);
+  benchMVP(MinTime);
+  benchText(MinTime);
+  return 0;
+}
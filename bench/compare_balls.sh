@@ -0,0 +1,22 @@
+#!/bin/sh
+# Copyright (c) 2025-2026 Ewan Crawford
+
+# Reports the CPU cost of culling and submitting the instanced sphere draw,
+# and the mean frame time, as the number of balls grows. Extra arguments are
+# passed to glsphere, e.g. --no-cull or --cull-threads N. Run from the build
+# directory, which holds glsphere along with the shaders, textures and fonts
+# it loads.
+set -e
+
+FRAMES=${FRAMES:-1000}
+GLSPHERE=${GLSPHERE:-./glsphere}
+
+printf '%-10s %-44s %-24s %s\n' "balls" "culling" "submission" \
+  "mean frame time"
+for Balls in 1 10 100 1000 10000 100000 1000000; do
+  Output=$("$GLSPHERE" --headless --frames "$FRAMES" --balls "$Balls" "$@")
+  Submit=$(echo "$Output" | sed -n 's/^Balls: .*, mean sphere submission //p')
+  Cull=$(echo "$Output" | sed -n 's/^Culling: mean //p')
+  Time=$(echo "$Output" | sed -n 's/^Mean frame time: //p')
+  printf '%-10s %-44s %-24s %s\n' "$Balls" "${Cull:--}" "$Submit" "$Time"
+done
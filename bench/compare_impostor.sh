@@ -0,0 +1,25 @@
+#!/bin/sh
+# Copyright (c) 2025-2026 Ewan Crawford
+
+# Compares the mean frame time of the ray-cast sphere impostor with the sphere
+# mesh at several tessellations. Run from the build directory, which holds
+# glsphere along with the shaders, textures and fonts it loads.
+set -e
+
+FRAMES=${FRAMES:-1000}
+GLSPHERE=${GLSPHERE:-./glsphere}
+
+run() {
+  Name=$1
+  shift
+  Time=$("$GLSPHERE" --headless --frames "$FRAMES" "$@" |
+    sed -n 's/^Mean frame time: //p')
+  printf '%-24s %s\n' "$Name" "$Time"
+}
+
+printf '%-24s %s\n' "sphere" "mean frame time"
+for Stacks in 18 64 256 1024 2048; do
+  Sectors=$((Stacks * 2))
+  run "mesh ${Stacks}x${Sectors}" --stacks "$Stacks" --sectors "$Sectors"
+done
+run "impostor" --impostor
@@ -0,0 +1,78 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#version 330 core
+#extension GL_ARB_conservative_depth : enable
+
+in vec3 CamQuadPos;
+
+out vec4 Color;
+#ifdef GL_ARB_conservative_depth
+// The visible hemisphere is in front of the quad, so depth only decreases
+layout(depth_less) out float gl_FragDepth;
+#endif
+
+uniform mat4 V;
+uniform mat4 P;
+uniform vec3 Center; // Worldspace
+uniform float Radius;
+uniform vec3 LightPosition; // Worldspace
+uniform sampler2D TexSampler;
+
+const float PI = 3.14159265358979;
+
+// Defined in phong.glsl
+vec3 shadePhong(vec3 Pos, vec3 LightPosition, vec3 CamNormal,
+                vec3 CamEyeDirection, vec3 CamLightDirection,
+                vec3 MaterialDiffuseColor);
+
+void main() {
+  // Intersect the ray from the eye through the fragment with the sphere, in
+  // camera space where the eye is at the origin
+  vec3 CamCenter = (V * vec4(Center, 1)).xyz;
+  vec3 Ray = normalize(CamQuadPos);
+  float B = dot(Ray, CamCenter);
+  float Discriminant = B * B - dot(CamCenter, CamCenter) + Radius * Radius;
+  // Missed fragments are discarded at the end, so derivatives below are taken
+  // with every fragment of the quad still active
+  float T = B - sqrt(max(Discriminant, 0.0));
+  vec3 CamPos = Ray * T;
+  vec3 CamNormal = (CamPos - CamCenter) / Radius;
+
+  // View matrix is a rigid transform, so its transpose rotates back
+  vec3 Normal = transpose(mat3(V)) * CamNormal;
+  vec3 Pos = Center + Normal * Radius;
+
+  // Same mapping as the sphere mesh, longitude then colatitude from +Y
+  float U = atan(-Normal.z, Normal.x) / (2.0 * PI);
+  vec2 UV = vec2(fract(U), acos(clamp(Normal.y, -1.0, 1.0)) / PI);
+
+  // u jumps from 1 to 0 at the seam, so also take derivatives of a copy that
+  // wraps on the opposite side and use the smaller to pick the mip level
+  float UAlt = fract(U + 0.5);
+  vec2 DX = dFdx(UV);
+  vec2 DY = dFdy(UV);
+  if (abs(dFdx(UAlt)) < abs(DX.x)) {
+    DX.x = dFdx(UAlt);
+  }
+  if (abs(dFdy(UAlt)) < abs(DY.x)) {
+    DY.x = dFdy(UAlt);
+  }
+  vec3 MaterialDiffuseColor = textureGrad(TexSampler, UV, DX, DY).rgb;
+
+  if (Discriminant < 0.0) {
+    discard;
+  }
+
+  // Vector that goes from the fragment to the camera, and from the fragment
+  // to the light, in camera space
+  vec3 CamEyeDirection = -CamPos;
+  vec3 CamLightPos = (V * vec4(LightPosition, 1)).xyz;
+  vec3 CamLightDirection = CamLightPos + CamEyeDirection;
+
+  Color = vec4(shadePhong(Pos, LightPosition, CamNormal, CamEyeDirection,
+                          CamLightDirection, MaterialDiffuseColor),
+               1.);
+
+  // Depth of the hit point rather than the quad, for the default depth range
+  vec4 ClipPos = P * vec4(CamPos, 1);
+  gl_FragDepth = (ClipPos.z / ClipPos.w) * 0.5 + 0.5;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#version 330 core
+
+// Camera facing quad covering the silhouette of the sphere, drawn as a
+// 4 vertex triangle strip without vertex buffers.
+
+out vec3 CamQuadPos; // cameraspace
+
+uniform mat4 V;
+uniform mat4 P;
+uniform vec3 Center; // Worldspace
+uniform float Radius;
+
+void main() {
+  vec2 Corner = vec2((gl_VertexID & 1) != 0 ? 1.0 : -1.0,
+                     (gl_VertexID & 2) != 0 ? 1.0 : -1.0);
+
+  // Quad through the centre, perpendicular to the direction from the eye
+  vec3 CamCenter = (V * vec4(Center, 1)).xyz;
+  float Dist = length(CamCenter);
+  vec3 Forward = CamCenter / Dist;
+  vec3 Up = abs(Forward.y) < 0.99 ? vec3(0, 1, 0) : vec3(1, 0, 0);
+  vec3 Right = normalize(cross(Forward, Up));
+  Up = cross(Right, Forward);
+
+  // Where the cone of rays touching the sphere crosses the quad
+  float HalfSize = Radius * Dist / sqrt(Dist * Dist - Radius * Radius);
+
+  CamQuadPos = CamCenter + (Corner.x * Right + Corner.y * Up) * HalfSize;
+  gl_Position = P * vec4(CamQuadPos, 1);
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#version 400 core
+
+layout(vertices = 3) out;
+
+in vec3 ControlDir[];
+in vec2 ControlUV[];
+
+out vec3 EvalDir[];
+out vec2 EvalUV[];
+
+uniform vec3 CameraPosition; // Worldspace
+uniform float Radius;
+// Pixels per world unit at distance 1 from the camera
+uniform float PixelsPerUnit;
+uniform float TargetEdgePixels;
+
+// Tessellation level for the arc between two corners, from its length in
+// pixels at the distance of its midpoint. Only depends on the two corners,
+// so patches sharing an edge agree on it and don't crack.
+float getEdgeLevel(vec3 A, vec3 B) {
+  float ArcLength = Radius * acos(clamp(dot(A, B), -1.0, 1.0));
+  float Dist = max(distance(CameraPosition, normalize(A + B) * Radius), 1e-3);
+  float EdgePixels = ArcLength * PixelsPerUnit / Dist;
+  return clamp(EdgePixels / TargetEdgePixels, 1.0, float(gl_MaxTessGenLevel));
+}
+
+void main() {
+  EvalDir[gl_InvocationID] = ControlDir[gl_InvocationID];
+  EvalUV[gl_InvocationID] = ControlUV[gl_InvocationID];
+
+  if (gl_InvocationID == 0) {
+    // Outer level i is the edge opposite corner i
+    gl_TessLevelOuter[0] = getEdgeLevel(ControlDir[1], ControlDir[2]);
+    gl_TessLevelOuter[1] = getEdgeLevel(ControlDir[2], ControlDir[0]);
+    gl_TessLevelOuter[2] = getEdgeLevel(ControlDir[0], ControlDir[1]);
+    gl_TessLevelInner[0] = max(gl_TessLevelOuter[0],
+                               max(gl_TessLevelOuter[1], gl_TessLevelOuter[2]));
+  }
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#version 400 core
+
+layout(triangles, fractional_odd_spacing, ccw) in;
+
+in vec3 EvalDir[];
+in vec2 EvalUV[];
+
+// Same outputs as sphere_vertex.glsl, for sphere_frag.glsl
+out vec3 Pos;               // worldspace
+out vec2 UV;                // worldspace
+out vec3 CamEyeDirection;   // cameraspace
+out vec3 CamLightDirection; // cameraspace
+out vec3 CamNormal;         // cameraspace
+out vec3 Tint;
+
+uniform mat4 MVP;
+uniform mat4 V;
+uniform vec3 LightPosition; // Worldspace
+uniform float Radius;
+
+const float PI = 3.14159265358979;
+
+void main() {
+  // Project the point of the flat patch onto the sphere
+  vec3 Normal = normalize(gl_TessCoord.x * EvalDir[0] +
+                          gl_TessCoord.y * EvalDir[1] +
+                          gl_TessCoord.z * EvalDir[2]);
+  Pos = Normal * Radius;
+
+  // Same mapping as the sphere mesh. The patch corners were split along the
+  // seam, so unwrapping u to the nearest of their interpolated value keeps
+  // it continuous across the patch. At the poles u is undefined, so the
+  // interpolated value is used as is.
+  vec2 PatchUV = gl_TessCoord.x * EvalUV[0] + gl_TessCoord.y * EvalUV[1] +
+                 gl_TessCoord.z * EvalUV[2];
+  float U = atan(-Normal.z, Normal.x) / (2.0 * PI);
+  U += round(PatchUV.x - U);
+  UV = vec2(abs(Normal.y) > 0.99999 ? PatchUV.x : U,
+            acos(clamp(Normal.y, -1.0, 1.0)) / PI);
+
+  gl_Position = MVP * vec4(Pos, 1);
+
+  // Vector that goes from the vertex to the camera, in camera space.
+  // In camera space, the camera is at the origin (0,0,0).
+  vec3 CamVertexPos = (V * vec4(Pos, 1)).xyz;
+  CamEyeDirection = vec3(0, 0, 0) - CamVertexPos;
+
+  // Vector that goes from the vertex to the light, in camera space.
+  vec3 CamLightPos = (V * vec4(LightPosition, 1)).xyz;
+  CamLightDirection = CamLightPos + CamEyeDirection;
+
+  // Normal of the vertex, in camera space
+  CamNormal = (V * vec4(Normal, 0)).xyz;
+  Tint = vec3(1);
+}
@@ -0,0 +1,14 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#version 400 core
+
+// Corners of the base icosahedron patches, refined by the tessellation stages
+layout(location = 0) in vec3 VertexPos; // Unit direction from the centre
+layout(location = 2) in vec2 VertexTexCoord;
+
+out vec3 ControlDir;
+out vec2 ControlUV;
+
+void main() {
+  ControlDir = VertexPos;
+  ControlUV = VertexTexCoord;
+}
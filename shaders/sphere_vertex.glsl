@@ -4,20 +4,83 @@
 layout(location = 0) in vec3 VertexPos;
 layout(location = 1) in vec3 VertexNormal;
 layout(location = 2) in vec2 VertexTexCoord;
+// Per ball attributes, see ballInstance
+layout(location = 3) in vec4 InstanceOffsetScale;
+layout(location = 4) in vec4 InstanceTint;
 
 out vec3 Pos;               // worldspace
 out vec2 UV;                // worldspace
 out vec3 CamEyeDirection;   // cameraspace
 out vec3 CamLightDirection; // cameraspace
 out vec3 CamNormal;         // cameraspace
+out vec3 Tint;
 
 uniform mat4 MVP;
 uniform mat4 V;
 uniform vec3 LightPosition; // Worldspace
+// Packed vertices store the unit direction from the centre as position
+uniform float PositionScale; // Sphere radius if packed, otherwise 1
+uniform bool DeriveNormal;   // Normal is the position direction if packed
+uniform vec2 TexCoordScale;  // Packed U is stored divided by PackedMaxU
+// Procedural UV sphere generated from gl_VertexID without vertex buffers
+uniform bool Procedural;
+uniform uint Stacks;
+uniform uint Sectors;
+
+const float PI = 3.14159265358979;
+
+// Stack and sector of the vertex, with triangles in the same order as the
+// sphere's index list: 1 triangle per sector on the first and last stacks,
+// 2 on the others.
+uvec2 getGridPosition(uint ID) {
+  uint Triangle = ID / 3u;
+  uint Corner = ID % 3u;
+
+  uint Stack;
+  uint Sector;
+  bool Upper; // K1---K2---K1+1 rather than K1+1---K2---K2+1
+  uint MiddleTriangles = 2u * Sectors * (Stacks - 2u);
+  if (Triangle < Sectors) {
+    Stack = 0u;
+    Sector = Triangle;
+    Upper = false;
+  } else if (Triangle - Sectors < MiddleTriangles) {
+    uint Middle = Triangle - Sectors;
+    Stack = 1u + Middle / (2u * Sectors);
+    Sector = (Middle / 2u) % Sectors;
+    Upper = (Middle % 2u) == 0u;
+  } else {
+    Stack = Stacks - 1u;
+    Sector = Triangle - Sectors - MiddleTriangles;
+    Upper = true;
+  }
+
+  // Corner 1 is always K2, the others are K1 or K1+1 when upper, otherwise
+  // K1+1 or K2+1
+  uint NextStack = (Corner == 1u || (!Upper && Corner == 2u)) ? 1u : 0u;
+  uint NextSector = Upper ? (Corner == 2u ? 1u : 0u) : (Corner == 1u ? 0u : 1u);
+  return uvec2(Stack + NextStack, Sector + NextSector);
+}
 
 void main() {
-  Pos = VertexPos;
-  UV = VertexTexCoord;
+  vec3 Normal;
+  if (Procedural) {
+    // Same formula as sphere::buildVertices(), north pole is +Y
+    uvec2 Grid = getGridPosition(uint(gl_VertexID));
+    float StackAngle = (PI / 2.0) - float(Grid.x) * PI / float(Stacks);
+    float SectorAngle = float(Grid.y) * 2.0 * PI / float(Sectors);
+    Normal = vec3(cos(StackAngle) * cos(SectorAngle), sin(StackAngle),
+                  -cos(StackAngle) * sin(SectorAngle));
+    Pos = Normal * PositionScale;
+    UV = vec2(float(Grid.y) / float(Sectors), float(Grid.x) / float(Stacks));
+  } else {
+    Pos = VertexPos * PositionScale;
+    UV = VertexTexCoord * TexCoordScale;
+    Normal = DeriveNormal ? VertexPos : VertexNormal;
+  }
+  // Uniform scale, so the normal is unchanged
+  Pos = InstanceOffsetScale.xyz + Pos * InstanceOffsetScale.w;
+  Tint = InstanceTint.rgb;
   gl_Position = MVP * vec4(Pos, 1);
 
   // Vector that goes from the vertex to the camera, in camera space.
@@ -30,5 +93,5 @@ void main() {
   CamLightDirection = CamLightPos + CamEyeDirection;
 
   // Normal of the vertex, in camera space
-  CamNormal = (V * vec4(VertexNormal, 0)).xyz;
+  CamNormal = (V * vec4(Normal, 0)).xyz;
 }
@@ -0,0 +1,403 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "assets.h"
+#include "glstate.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <stb_image.h>
+
+// Last, as it redirects GL 1.1 calls when counting them
+#include "glcount.h"
+
+namespace {
+// More threads than files only adds contention on the disk
+constexpr unsigned MaxLoaderThreads = 4;
+
+// Wraps Func as a copyable Job, returning the future of its result
+template <typename Fn>
+auto makeJob(Fn &&Func, std::function<void()> &Job) {
+  using resultType = decltype(Func());
+  auto Task = std::make_shared<std::packaged_task<resultType()>>(
+      std::forward<Fn>(Func));
+  Job = [Task]() { (*Task)(); };
+  return Task->get_future();
+}
+} // namespace
+
+assetLoader::assetLoader(unsigned NumThreads) : MStop(false) {
+  if (NumThreads == 0) {
+    NumThreads = std::clamp(std::thread::hardware_concurrency(), 1u,
+                            MaxLoaderThreads);
+  }
+  MWorkers.reserve(NumThreads);
+  for (unsigned T = 0; T < NumThreads; T++) {
+    MWorkers.emplace_back(&assetLoader::workerLoop, this);
+  }
+}
+
+assetLoader::~assetLoader() {
+  {
+    std::lock_guard<std::mutex> Lock(MMutex);
+    MStop = true;
+    MJobs.clear();
+  }
+  MWake.notify_all();
+  for (auto &Worker : MWorkers) {
+    Worker.join();
+  }
+}
+
+void assetLoader::push(std::function<void()> Job) {
+  {
+    std::lock_guard<std::mutex> Lock(MMutex);
+    MJobs.push_back(std::move(Job));
+  }
+  MWake.notify_one();
+}
+
+void assetLoader::workerLoop() {
+  while (true) {
+    std::function<void()> Job;
+    {
+      std::unique_lock<std::mutex> Lock(MMutex);
+      MWake.wait(Lock, [this]() { return MStop || !MJobs.empty(); });
+      if (MStop) {
+        return;
+      }
+      Job = std::move(MJobs.front());
+      MJobs.pop_front();
+    }
+    Job();
+  }
+}
+
+std::future<image> assetLoader::loadImage(const std::string &Path,
+                                          int Channels) {
+  std::function<void()> Job;
+  auto Future = makeJob(
+      [Path, Channels]() {
+        TRACE_ZONE("loadImage");
+        int Width, Height, FileChannels;
+        unsigned char *Data =
+            stbi_load(Path.c_str(), &Width, &Height, &FileChannels, Channels);
+        if (!Data) {
+          throw std::runtime_error(
+              std::string("Texture failed to load at path: ") + Path);
+        }
+        return image{Width, Height, Channels, {Data, stbi_image_free}};
+      },
+      Job);
+  push(std::move(Job));
+  return Future;
+}
+
+std::future<std::vector<unsigned char>>
+assetLoader::readFile(const std::string &Path) {
+  std::function<void()> Job;
+  auto Future = makeJob(
+      [Path]() {
+        TRACE_ZONE("readFile");
+        std::ifstream File(Path, std::ios::binary | std::ios::ate);
+        if (!File.is_open()) {
+          throw std::runtime_error(std::string("Could not open file ") + Path);
+        }
+        std::vector<unsigned char> Data(File.tellg());
+        File.seekg(0);
+        if (!File.read(reinterpret_cast<char *>(Data.data()), Data.size())) {
+          throw std::runtime_error(std::string("Could not read file ") + Path);
+        }
+        return Data;
+      },
+      Job);
+  push(std::move(Job));
+  return Future;
+}
+
+textureFiles assetLoader::loadTexture(const std::string &CookedPath,
+                                      const std::vector<std::string> &Sources,
+                                      int Channels, bool UseCooked) {
+  textureFiles Files;
+  std::error_code Error;
+  Files.Loader = this;
+  if (UseCooked && std::filesystem::exists(CookedPath, Error)) {
+    Files.Cooked = loadCooked(CookedPath);
+    return Files;
+  }
+  for (const std::string &Source : Sources) {
+    Files.Images.push_back(loadImage(Source, Channels));
+  }
+  return Files;
+}
+
+std::future<cookedTexture> assetLoader::loadCooked(const std::string &Path) {
+  std::function<void()> Job;
+  auto Future = makeJob(
+      [Path]() {
+        TRACE_ZONE("loadCooked");
+        return cookedTexture(Path);
+      },
+      Job);
+  push(std::move(Job));
+  return Future;
+}
+
+std::future<void> assetLoader::run(std::function<void()> Func) {
+  std::function<void()> Job;
+  auto Future = makeJob(std::move(Func), Job);
+  push(std::move(Job));
+  return Future;
+}
+
+asyncTexture::asyncTexture(GLenum Target, textureFiles Files,
+                           std::array<GLubyte, 4> Placeholder, bool Mipmaps)
+    : MTarget(Target), MMipmaps(Mipmaps), MImages(std::move(Files.Images)),
+      MCooked(std::move(Files.Cooked)), MLoader(Files.Loader),
+      MEncoding(nullptr), MFormat(0), MNumLevels(0), MStaging(0),
+      MTexture(0), MBytes(0), MLoaded(false) {
+  // One texel of each face, which every filter and wrap mode samples alike
+  glGenTextures(1, &MTexture);
+  glState::get().bindTexture(0, MTarget, MTexture);
+  for (unsigned i = 0; i < getNumFaces(); i++) {
+    glTexImage2D(getFaceTarget(i), 0, GL_RGBA8, 1, 1, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, Placeholder.data());
+  }
+  glTexParameteri(MTarget, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(MTarget, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+asyncTexture::~asyncTexture() { freeTexture(); }
+
+void asyncTexture::freeTexture() {
+  // The copy job writes to the staging buffer, so must finish first
+  if (MCopied.valid()) {
+    MCopied.wait();
+  }
+  if (MStaging != 0) {
+    glDeleteBuffers(1, &MStaging);
+    MStaging = 0;
+  }
+  if (MTexture != 0) {
+    glDeleteTextures(1, &MTexture);
+    MTexture = 0;
+  }
+}
+
+GLenum asyncTexture::getFaceTarget(unsigned Face) const {
+  return MTarget == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + Face
+                                        : MTarget;
+}
+
+bool asyncTexture::update(bool Wait) {
+  if (MLoaded) {
+    return true;
+  }
+  auto isReady = [Wait](auto &Future) {
+    return Wait || Future.wait_for(std::chrono::seconds(0)) ==
+                       std::future_status::ready;
+  };
+
+  if (!MCopied.valid()) {
+    if (MCooked.valid()) {
+      if (!isReady(MCooked)) {
+        return false;
+      }
+      prepareCooked(MCooked.get());
+    } else {
+      for (auto &Image : MImages) {
+        if (!isReady(Image)) {
+          return false;
+        }
+      }
+      std::vector<image> Decoded;
+      for (auto &Image : MImages) {
+        Decoded.push_back(Image.get());
+      }
+      MImages.clear();
+      prepareImages(std::move(Decoded));
+    }
+    stage();
+  }
+
+  if (!isReady(MCopied)) {
+    return false;
+  }
+  // Rethrows any error copying the levels
+  MCopied.get();
+  upload();
+  return true;
+}
+
+void asyncTexture::prepareImages(std::vector<image> Decoded) {
+  const image &First = Decoded.front();
+  if (Decoded.size() != getNumFaces()) {
+    throw std::runtime_error("Texture has the wrong number of faces");
+  }
+  for (size_t i = 0; i < Decoded.size(); i++) {
+    const image &Image = Decoded[i];
+    if (Image.Width != First.Width || Image.Height != First.Height ||
+        Image.Channels != First.Channels) {
+      throw std::runtime_error("Texture images differ in size");
+    }
+    MLevels.push_back({getFaceTarget(i), 0, Image.Width, Image.Height,
+                       Image.Pixels.get(), Image.getSize()});
+  }
+
+  // Mipmaps are generated from the first level once it is uploaded
+  MNumLevels = MMipmaps ? static_cast<GLsizei>(
+                              std::log2(std::max(First.Width, First.Height))) +
+                              1
+                        : 1;
+  MFormat = First.Channels == 4 ? GL_RGBA8 : GL_RGB8;
+  MBytes = 0;
+  for (GLsizei L = 0; L < MNumLevels; L++) {
+    MBytes += size_t(std::max(First.Width >> L, 1)) *
+              std::max(First.Height >> L, 1) * First.Channels *
+              Decoded.size();
+  }
+  // Kept until uploaded, as the levels point at their pixels
+  MDecoded = std::move(Decoded);
+}
+
+void asyncTexture::prepareCooked(cookedTexture Cooked) {
+  const cookedHeader &Header = Cooked.getHeader();
+  if (Header.Faces != getNumFaces()) {
+    throw std::runtime_error("Cooked texture has the wrong number of faces");
+  }
+  // GL is up by now, so only the encoding it supports is read
+  const cookedEncoding *Encoding = Cooked.chooseEncoding();
+  if (!Encoding) {
+    throw std::runtime_error("Cooked texture has no supported encoding");
+  }
+  MCookedFile = std::make_unique<cookedTexture>(std::move(Cooked));
+  MEncoding = Encoding;
+
+  // Every level is stored, so nothing is decoded or generated
+  for (unsigned L = 0; L < Header.Levels; L++) {
+    for (unsigned F = 0; F < Header.Faces; F++) {
+      size_t Size;
+      const unsigned char *Data = MCookedFile->getLevel(*Encoding, L, F, Size);
+      MLevels.push_back({getFaceTarget(F), static_cast<GLint>(L),
+                         static_cast<GLsizei>(std::max(Header.Width >> L, 1u)),
+                         static_cast<GLsizei>(std::max(Header.Height >> L, 1u)),
+                         Data, Size});
+    }
+  }
+  MNumLevels = Header.Levels;
+  MFormat = Encoding->Format;
+  MBytes = Encoding->Size;
+}
+
+void asyncTexture::stage() {
+  TRACE_ZONE("asyncTexture::stage");
+  size_t Bytes = 0;
+  for (const levelData &Level : MLevels) {
+    Bytes += Level.Size;
+  }
+
+  // Left mapped while a loader thread fills it, and unbound meanwhile so
+  // other pixel transfers read client memory
+  glState &State = glState::get();
+  glGenBuffers(1, &MStaging);
+  State.bindBuffer(GL_PIXEL_UNPACK_BUFFER, MStaging);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, Bytes, nullptr, GL_STREAM_DRAW);
+  char *Staging = static_cast<char *>(
+      glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, Bytes,
+                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  State.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  if (!Staging) {
+    throw std::runtime_error("Could not map texture upload buffer");
+  }
+
+  auto Copy = [Staging, Levels = MLevels, Cooked = MCookedFile.get(),
+               Encoding = MEncoding]() {
+    TRACE_ZONE("copyLevels");
+    if (Cooked) {
+      Cooked->prefetch(*Encoding);
+    }
+    size_t Offset = 0;
+    for (const levelData &Level : Levels) {
+      std::memcpy(Staging + Offset, Level.Data, Level.Size);
+      Offset += Level.Size;
+    }
+  };
+  if (MLoader) {
+    MCopied = MLoader->run(std::move(Copy));
+  } else {
+    std::promise<void> Copied;
+    Copy();
+    Copied.set_value();
+    MCopied = Copied.get_future();
+  }
+}
+
+void asyncTexture::upload() {
+  TRACE_ZONE("asyncTexture::upload");
+  glState &State = glState::get();
+  State.bindBuffer(GL_PIXEL_UNPACK_BUFFER, MStaging);
+  const bool Mapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+
+  GLuint Texture;
+  glGenTextures(1, &Texture);
+  State.bindTexture(0, MTarget, Texture);
+  glTexStorage2D(MTarget, MNumLevels, MFormat, MLevels.front().Width,
+                 MLevels.front().Height);
+  // Rows of three channel images needn't be 4 byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  size_t Offset = 0;
+  for (size_t i = 0; Mapped && i < MLevels.size(); i++) {
+    const levelData &Level = MLevels[i];
+    // Only queues a copy from the buffer, which the driver does on its own
+    const void *Source = reinterpret_cast<const void *>(Offset);
+    if (isCookedCompressed(MFormat)) {
+      glCompressedTexSubImage2D(Level.Target, Level.Level, 0, 0, Level.Width,
+                                Level.Height, MFormat, Level.Size, Source);
+    } else {
+      glTexSubImage2D(Level.Target, Level.Level, 0, 0, Level.Width,
+                      Level.Height, MFormat == GL_RGB8 ? GL_RGB : GL_RGBA,
+                      GL_UNSIGNED_BYTE, Source);
+    }
+    Offset += Level.Size;
+  }
+  State.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  // Only the name is freed now, the storage is kept until the copies from
+  // it complete
+  glDeleteBuffers(1, &MStaging);
+  MStaging = 0;
+  const bool OnlyFirstLevel = MLevels.back().Level == 0;
+  const GLsizei NumLevels = MNumLevels;
+  MLevels.clear();
+  MDecoded.clear();
+  MCookedFile.reset();
+  if (!Mapped) {
+    glDeleteTextures(1, &Texture);
+    throw std::runtime_error("Texture upload buffer was lost");
+  }
+
+  // Levels which weren't uploaded are generated
+  const bool Mipmapped = NumLevels > 1;
+  if (Mipmapped && OnlyFirstLevel) {
+    glGenerateMipmap(MTarget);
+  }
+  glTexParameteri(MTarget, GL_TEXTURE_MIN_FILTER,
+                  Mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(MTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if (MTarget == GL_TEXTURE_CUBE_MAP) {
+    glTexParameteri(MTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(MTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(MTarget, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  } else {
+    glTexParameteri(MTarget, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(MTarget, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  }
+
+  // The real texture is bound, so the cache never holds the placeholder
+  glDeleteTextures(1, &MTexture);
+  MTexture = Texture;
+  MLoaded = true;
+}
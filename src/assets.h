@@ -0,0 +1,164 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include "cooked.h"
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// clang-format on
+
+// Decoded image with 8 bits per channel
+struct image {
+  int Width;
+  int Height;
+  int Channels;
+  std::unique_ptr<unsigned char, void (*)(void *)> Pixels;
+
+  size_t getSize() const { return size_t(Width) * Height * Channels; }
+};
+
+struct assetLoader;
+
+// Files of a texture queued on an assetLoader, either a cooked texture or
+// its source images
+struct textureFiles {
+  std::future<cookedTexture> Cooked;
+  std::vector<std::future<image>> Images;
+  // Loader which copies the levels into the staging buffer once loaded
+  assetLoader *Loader = nullptr;
+};
+
+// Threads which read and decode asset files off the GL thread. Each job
+// returns a future, which rethrows any error the job threw when its result
+// is taken.
+//
+// Unlike workerPool the jobs are independent and queued up front, so the
+// GL thread carries on creating the context and other objects while they
+// run. Jobs still queued when the loader is destroyed are dropped.
+struct assetLoader {
+  // NumThreads of 0 uses one thread per hardware thread, up to a few as
+  // the jobs are mostly decoding a handful of files
+  explicit assetLoader(unsigned NumThreads = 0);
+  ~assetLoader();
+
+  assetLoader(const assetLoader &) = delete;
+  assetLoader &operator=(const assetLoader &) = delete;
+
+  // Decodes the image at Path to Channels channels
+  std::future<image> loadImage(const std::string &Path, int Channels);
+  // Reads the whole file at Path
+  std::future<std::vector<unsigned char>> readFile(const std::string &Path);
+  // Maps the cooked texture at Path
+  std::future<cookedTexture> loadCooked(const std::string &Path);
+  // Runs Func on a loader thread
+  std::future<void> run(std::function<void()> Func);
+  // Loads the cooked texture at CookedPath if UseCooked and it exists,
+  // otherwise decodes Sources to Channels channels
+  textureFiles loadTexture(const std::string &CookedPath,
+                           const std::vector<std::string> &Sources,
+                           int Channels, bool UseCooked);
+
+  unsigned getNumThreads() const { return MWorkers.size(); }
+
+private:
+  void push(std::function<void()> Job);
+  void workerLoop();
+
+  std::vector<std::thread> MWorkers;
+  std::mutex MMutex;
+  std::condition_variable MWake;
+  // Guarded by MMutex
+  std::deque<std::function<void()>> MJobs;
+  bool MStop;
+};
+
+// Texture sampled as a placeholder of one colour until its files are
+// loaded, then swapped for the real texture. Once loaded, the GL thread maps
+// a pixel unpack buffer and a loader thread copies the levels into it. The
+// texture is then uploaded from the buffer, which only queues a transfer the
+// driver performs on its own, so the GL thread never copies pixels.
+//
+// Cooked textures are uploaded as stored, in the best encoding the driver
+// supports, and only that encoding is read from disk. Decoded images only
+// have their first level uploaded, and the rest generated when Mipmaps is
+// set.
+struct asyncTexture {
+  // Target is GL_TEXTURE_2D with one image, or GL_TEXTURE_CUBE_MAP with six
+  // faces in +X, -X, +Y, -Y, +Z, -Z order which must be the same size
+  asyncTexture(GLenum Target, textureFiles Files,
+               std::array<GLubyte, 4> Placeholder, bool Mipmaps);
+  ~asyncTexture();
+
+  asyncTexture(const asyncTexture &) = delete;
+  asyncTexture &operator=(const asyncTexture &) = delete;
+
+  // Uploads the texture once its files are loaded and copied, returning
+  // true once the real texture is in use. Only blocks on loading with Wait.
+  // Throws if any file failed to load.
+  bool update(bool Wait = false);
+
+  // Texture to sample this frame, the placeholder or the real one
+  GLuint get() const { return MTexture; }
+  bool isLoaded() const { return MLoaded; }
+  // Bytes of every level of the real texture, 0 until loaded
+  size_t getBytes() const { return MLoaded ? MBytes : 0; }
+
+  // Also waits for any copy into the staging buffer, which it frees
+  void freeTexture();
+
+private:
+  // One face of one level, copied into the staging buffer
+  struct levelData {
+    GLenum Target;
+    GLint Level;
+    GLsizei Width;
+    GLsizei Height;
+    const void *Data;
+    size_t Size;
+  };
+
+  unsigned getNumFaces() const {
+    return MTarget == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+  }
+  GLenum getFaceTarget(unsigned Face) const;
+
+  // Set the levels to upload, keeping the files they point into
+  void prepareImages(std::vector<image> Decoded);
+  void prepareCooked(cookedTexture Cooked);
+  // Maps the staging buffer and queues the copy of the levels into it
+  void stage();
+  // Creates the texture from the staging buffer, the largest level first,
+  // generating any levels missing
+  void upload();
+
+  GLenum MTarget;
+  bool MMipmaps;
+  // Files left to load, both empty once loaded
+  std::vector<std::future<image>> MImages;
+  std::future<cookedTexture> MCooked;
+  assetLoader *MLoader;
+
+  // Levels being staged, and the files holding them
+  std::vector<levelData> MLevels;
+  std::vector<image> MDecoded;
+  std::unique_ptr<cookedTexture> MCookedFile;
+  const cookedEncoding *MEncoding;
+  GLenum MFormat;
+  GLsizei MNumLevels;
+  // Mapped until the copy into it completes
+  GLuint MStaging;
+  std::future<void> MCopied;
+
+  GLuint MTexture;
+  size_t MBytes;
+  bool MLoaded;
+};
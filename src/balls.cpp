@@ -0,0 +1,73 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "balls.h"
+#include "parallel.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Half the width of the grid, leaving room for the camera inside the skybox
+constexpr float GridExtent = 3.0f;
+// Gap between neighbouring ball centres, before shrinking to fit the grid
+constexpr float MaxSpacing = 2.5f;
+// Ball radius as a fraction of the spacing
+constexpr float RadiusFraction = 0.4f;
+// Instances written per thread
+constexpr size_t MinBallsPerThread = 1 << 15;
+
+// Fully saturated colour with hue H in [0, 1)
+void getHueColor(float H, GLubyte (&Tint)[4]) {
+  for (unsigned C = 0; C < 3; C++) {
+    // Offset the hue by a third for each channel of a triangle wave
+    float Phase = std::fmod(H + C / 3.0f, 1.0f);
+    float Value = std::clamp(std::fabs(Phase * 6.0f - 3.0f) - 1.0f, 0.0f, 1.0f);
+    Tint[C] = static_cast<GLubyte>(std::lround(Value * 255.0f));
+  }
+  Tint[3] = 255;
+}
+
+// Balls along each edge of the grid
+unsigned getGridSide(unsigned NumBalls) {
+  unsigned Side = std::max(1.0, std::ceil(std::cbrt(double(NumBalls))));
+  // Rounding in cbrt() can leave the cube one short
+  while (size_t(Side) * Side * Side < NumBalls) {
+    Side++;
+  }
+  return Side;
+}
+
+float getSpacing(unsigned NumBalls) {
+  return std::min(MaxSpacing, 2.0f * GridExtent / getGridSide(NumBalls));
+}
+} // namespace
+
+float getBallScale(unsigned NumBalls) {
+  return getSpacing(NumBalls) * RadiusFraction;
+}
+
+std::vector<ballInstance> buildBalls(unsigned NumBalls) {
+  TRACE_ZONE("buildBalls");
+  std::vector<ballInstance> Balls(NumBalls);
+  const unsigned Side = getGridSide(NumBalls);
+  const float Spacing = getSpacing(NumBalls);
+  const float Scale = getBallScale(NumBalls);
+  const float First = -0.5f * Spacing * (Side - 1);
+
+  parallelFor(NumBalls, MinBallsPerThread, [&](size_t Begin, size_t End) {
+    for (size_t i = Begin; i < End; i++) {
+      ballInstance &Ball = Balls[i];
+      Ball.OffsetScale[0] = First + Spacing * (i % Side);
+      Ball.OffsetScale[1] = First + Spacing * ((i / Side) % Side);
+      Ball.OffsetScale[2] = First + Spacing * (i / (size_t(Side) * Side));
+      Ball.OffsetScale[3] = Scale;
+      if (NumBalls == 1) {
+        std::fill(std::begin(Ball.Tint), std::end(Ball.Tint), 255);
+      } else {
+        // Golden ratio steps spread neighbouring hues apart
+        getHueColor(std::fmod(i * 0.618034f, 1.0f), Ball.Tint);
+      }
+    }
+  });
+  return Balls;
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <vector>
+// clang-format on
+
+// Per instance attributes of a ball, read with a vertex attribute divisor
+// of 1. Offset and scale are applied to the unit sphere in the vertex
+// shader, and the tint multiplies its texture.
+struct ballInstance {
+  GLfloat OffsetScale[4]; // xyz offset, w scale
+  GLubyte Tint[4];        // unorm8 RGB, A unused
+};
+static_assert(sizeof(ballInstance) == 20, "Unexpected ballInstance padding");
+
+// Lays out NumBalls balls on a cubic grid centred on the origin which fits
+// inside the skybox. A single ball is the original untinted sphere at the
+// origin, more are tinted by index.
+std::vector<ballInstance> buildBalls(unsigned NumBalls);
+
+// Scale buildBalls() gives every ball
+float getBallScale(unsigned NumBalls);
@@ -2,11 +2,14 @@
 #include "controls.h"
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <string_view>
 
 controls::controls(GLFWwindow *Window, int WindowWidth, int WindowHeight)
     : MWindow(Window), MWindowWidth(WindowWidth), MWindowHeight(WindowHeight),
-      MLastTime(0.0) {
+      MViewMatrix(1.f), MProjMatrix(1.f), MDetailSteps(0),
+      MDetailKeyHeld(false), MLastTime(0.0) {
   // Initial position +Z
   MPosition = glm::vec3(0, 0, 3);
 
@@ -22,28 +25,29 @@ void controls::refreshMatrices() {
   const float Speed = 3.0f; // 3 units / second
   const float MouseSpeed = 0.005f;
 
-  if (MLastTime == 0.0) {
-    MLastTime = glfwGetTime();
-    return;
-  }
+  // Without a window there is no user input, so the camera stays fixed at
+  // its initial position and orientation.
+  const bool HasInput = MWindow && MLastTime != 0.0;
 
   // Compute time difference between current and last frame
   double CurrentTime = glfwGetTime();
-  float DeltaTime = float(CurrentTime - MLastTime);
-
-  // Get mouse position
-  double XPos, YPos;
-  glfwGetCursorPos(MWindow, &XPos, &YPos);
-
-  // Reset mouse position for next frame
-  glfwSetCursorPos(MWindow, MWindowWidth / 2, MWindowHeight / 2);
-
-  // Compute new orientation
-  if (XPos != 0) {
-    MHorizAngle += MouseSpeed * float(MWindowWidth / 2 - XPos);
-  }
-  if (YPos != 0) {
-    MVertAngle += MouseSpeed * float(MWindowHeight / 2 - YPos);
+  float DeltaTime = HasInput ? float(CurrentTime - MLastTime) : 0.0f;
+
+  if (HasInput) {
+    // Get mouse position
+    double XPos, YPos;
+    glfwGetCursorPos(MWindow, &XPos, &YPos);
+
+    // Reset mouse position for next frame
+    glfwSetCursorPos(MWindow, MWindowWidth / 2, MWindowHeight / 2);
+
+    // Compute new orientation
+    if (XPos != 0) {
+      MHorizAngle += MouseSpeed * float(MWindowWidth / 2 - XPos);
+    }
+    if (YPos != 0) {
+      MVertAngle += MouseSpeed * float(MWindowHeight / 2 - YPos);
+    }
   }
 
   // Direction : Spherical coordinates to Cartesian coordinates conversion
@@ -58,22 +62,35 @@ void controls::refreshMatrices() {
   glm::vec3 Up = glm::cross(Right, Direction);
 
   // Move forward
-  if (glfwGetKey(MWindow, GLFW_KEY_UP) == GLFW_PRESS) {
+  if (HasInput && glfwGetKey(MWindow, GLFW_KEY_UP) == GLFW_PRESS) {
     MPosition += Direction * DeltaTime * Speed;
   }
   // Move backward
-  if (glfwGetKey(MWindow, GLFW_KEY_DOWN) == GLFW_PRESS) {
+  if (HasInput && glfwGetKey(MWindow, GLFW_KEY_DOWN) == GLFW_PRESS) {
     MPosition -= Direction * DeltaTime * Speed;
   }
   // Strafe right
-  if (glfwGetKey(MWindow, GLFW_KEY_RIGHT) == GLFW_PRESS) {
+  if (HasInput && glfwGetKey(MWindow, GLFW_KEY_RIGHT) == GLFW_PRESS) {
     MPosition += Right * DeltaTime * Speed;
   }
   // Strafe left
-  if (glfwGetKey(MWindow, GLFW_KEY_LEFT) == GLFW_PRESS) {
+  if (HasInput && glfwGetKey(MWindow, GLFW_KEY_LEFT) == GLFW_PRESS) {
     MPosition -= Right * DeltaTime * Speed;
   }
 
+  // Change sphere detail once per key press
+  if (HasInput) {
+    const int MaxDetailSteps = 6;
+    const bool MorePressed = glfwGetKey(MWindow, GLFW_KEY_EQUAL) == GLFW_PRESS;
+    const bool LessPressed = glfwGetKey(MWindow, GLFW_KEY_MINUS) == GLFW_PRESS;
+    if (!MDetailKeyHeld && MorePressed) {
+      MDetailSteps = std::min(MDetailSteps + 1, MaxDetailSteps);
+    } else if (!MDetailKeyHeld && LessPressed) {
+      MDetailSteps = std::max(MDetailSteps - 1, -MaxDetailSteps);
+    }
+    MDetailKeyHeld = MorePressed || LessPressed;
+  }
+
   // Limit camera from moving outside of the skybox
   MPosition = glm::clamp(MPosition, glm::vec3(-4.f, -4.f, -4.f),
                          glm::vec3(4.f, 4.f, 4.f));
@@ -94,8 +111,29 @@ void controls::refreshMatrices() {
 }
 
 std::string controls::getPositionStr() const {
-  std::stringstream sstr;
-  sstr << "Camera Position (" << MPosition.x << ", " << MPosition.y << ", "
-       << MPosition.z << ")";
-  return sstr.str();
+  char Buffer[PositionStrSize];
+  return std::string(Buffer, formatPosition(Buffer, sizeof(Buffer)));
+}
+
+size_t controls::formatPosition(char *Buffer, size_t Size) const {
+  char *Out = Buffer;
+  char *const End = Buffer + Size;
+  auto Append = [&](std::string_view Str) {
+    Out = std::copy_n(Str.data(), std::min<size_t>(Str.size(), End - Out), Out);
+  };
+
+  Append("Camera Position (");
+  for (unsigned i = 0; i < 3; i++) {
+    if (i) {
+      Append(", ");
+    }
+    // Matches the default formatting of a float by std::ostream
+    auto Result = std::to_chars(Out, End, MPosition[i],
+                                std::chars_format::general, 6);
+    if (Result.ec == std::errc()) {
+      Out = Result.ptr;
+    }
+  }
+  Append(")");
+  return Out - Buffer;
 }
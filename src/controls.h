@@ -6,6 +6,8 @@
 #include <string>
 
 struct controls {
+  // A null Window disables user input, leaving the camera at its initial
+  // position and orientation.
   controls(GLFWwindow *Window, int WindowWidth, int WindowHeight);
 
   void refreshMatrices();
@@ -18,10 +20,19 @@ struct controls {
     return MProjMatrix * View * ModelMatrix;
   }
 
+  glm::vec3 getPosition() const { return MPosition; }
+  // Times the sphere detail has been doubled with '=', or halved with '-'
+  // when negative
+  int getDetailSteps() const { return MDetailSteps; }
   std::string getPositionStr() const;
+  // Writes getPositionStr() to Buffer without allocating, truncated to Size,
+  // and returns its length
+  size_t formatPosition(char *Buffer, size_t Size) const;
+  // Buffer size which formatPosition() never truncates
+  static constexpr size_t PositionStrSize = 64;
 
 private:
-  GLFWwindow *MWindow; // Non owning
+  GLFWwindow *MWindow; // Non owning, may be null
   int MWindowWidth;
   int MWindowHeight;
 
@@ -32,5 +43,8 @@ private:
   float MHorizAngle;
   float MVertAngle;
 
+  int MDetailSteps;
+  bool MDetailKeyHeld;
+
   double MLastTime;
 };
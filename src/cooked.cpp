@@ -0,0 +1,135 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "cooked.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+size_t getCookedLevelSize(GLenum Format, unsigned Width, unsigned Height) {
+  switch (Format) {
+  case CookedBC1:
+    // 4x4 blocks of 8 bytes, partial blocks at the edges are whole
+    return size_t((Width + 3) / 4) * ((Height + 3) / 4) * 8;
+  case CookedRGBA8:
+    return size_t(Width) * Height * 4;
+  default:
+    return 0;
+  }
+}
+
+bool isCookedCompressed(GLenum Format) { return Format == CookedBC1; }
+
+cookedTexture::cookedTexture(const std::string &Path)
+    : MData(nullptr), MSize(0), MHeader(nullptr), MEncodings(nullptr) {
+  int FD = open(Path.c_str(), O_RDONLY);
+  if (FD < 0) {
+    throw std::runtime_error(std::string("Could not open cooked texture ") +
+                             Path);
+  }
+  struct stat Stat;
+  void *Map = MAP_FAILED;
+  if (fstat(FD, &Stat) == 0 && Stat.st_size > 0) {
+    MSize = Stat.st_size;
+    Map = mmap(nullptr, MSize, PROT_READ, MAP_PRIVATE, FD, 0);
+  }
+  // The mapping outlives the descriptor
+  close(FD);
+  if (Map == MAP_FAILED) {
+    throw std::runtime_error(std::string("Could not map cooked texture ") +
+                             Path);
+  }
+  MData = static_cast<const unsigned char *>(Map);
+
+  auto invalid = [&]() {
+    munmap(const_cast<unsigned char *>(MData), MSize);
+    return std::runtime_error(std::string("Invalid cooked texture ") + Path);
+  };
+  if (MSize < sizeof(cookedHeader)) {
+    throw invalid();
+  }
+  MHeader = reinterpret_cast<const cookedHeader *>(MData);
+  const cookedHeader &H = *MHeader;
+  if (std::memcmp(H.Magic, CookedMagic, sizeof(CookedMagic)) != 0 ||
+      (H.Faces != 1 && H.Faces != 6) || H.Width == 0 || H.Height == 0 ||
+      H.Levels == 0 || H.NumEncodings > MSize / sizeof(cookedEncoding) ||
+      sizeof(cookedHeader) + H.NumEncodings * sizeof(cookedEncoding) > MSize) {
+    throw invalid();
+  }
+  const unsigned MaxLevels =
+      1 + static_cast<unsigned>(std::log2(std::max(H.Width, H.Height)));
+  if (H.Levels > MaxLevels) {
+    throw invalid();
+  }
+  MEncodings =
+      reinterpret_cast<const cookedEncoding *>(MData + sizeof(cookedHeader));
+
+  // Encodings of a known format must hold exactly their levels
+  for (unsigned E = 0; E < H.NumEncodings; E++) {
+    const cookedEncoding &Encoding = MEncodings[E];
+    if (Encoding.Offset > MSize || Encoding.Size > MSize - Encoding.Offset) {
+      throw invalid();
+    }
+    uint64_t Size = 0;
+    for (unsigned L = 0; L < H.Levels; L++) {
+      Size += getCookedLevelSize(Encoding.Format, std::max(H.Width >> L, 1u),
+                                 std::max(H.Height >> L, 1u)) *
+              H.Faces;
+    }
+    if (Size != 0 && Size != Encoding.Size) {
+      throw invalid();
+    }
+  }
+}
+
+cookedTexture::cookedTexture(cookedTexture &&Other)
+    : MData(Other.MData), MSize(Other.MSize), MHeader(Other.MHeader),
+      MEncodings(Other.MEncodings) {
+  Other.MData = nullptr;
+}
+
+cookedTexture::~cookedTexture() {
+  if (MData) {
+    munmap(const_cast<unsigned char *>(MData), MSize);
+  }
+}
+
+const cookedEncoding *cookedTexture::chooseEncoding() const {
+  const cookedEncoding *RGBA8 = nullptr;
+  for (unsigned E = 0; E < MHeader->NumEncodings; E++) {
+    const cookedEncoding &Encoding = MEncodings[E];
+    if (Encoding.Format == CookedBC1 && GLEW_EXT_texture_compression_s3tc) {
+      return &Encoding;
+    }
+    if (Encoding.Format == CookedRGBA8) {
+      RGBA8 = &Encoding;
+    }
+  }
+  return RGBA8;
+}
+
+void cookedTexture::prefetch(const cookedEncoding &Encoding) const {
+  // madvise() takes a page aligned start
+  const size_t PageSize = sysconf(_SC_PAGESIZE);
+  const size_t Begin = Encoding.Offset / PageSize * PageSize;
+  const size_t End = Encoding.Offset + Encoding.Size;
+  madvise(const_cast<unsigned char *>(MData) + Begin, End - Begin,
+          MADV_WILLNEED);
+}
+
+const unsigned char *cookedTexture::getLevel(const cookedEncoding &Encoding,
+                                             unsigned Level, unsigned Face,
+                                             size_t &Size) const {
+  const cookedHeader &H = *MHeader;
+  size_t Offset = Encoding.Offset;
+  for (unsigned L = 0; L <= Level; L++) {
+    Size = getCookedLevelSize(Encoding.Format, std::max(H.Width >> L, 1u),
+                              std::max(H.Height >> L, 1u));
+    Offset += Size * (L < Level ? H.Faces : Face);
+  }
+  return MData + Offset;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+// clang-format on
+
+// Texture cooked offline by glsphere_cook, with every mip level precomputed
+// in one or more encodings. The file is a cookedHeader, then NumEncodings
+// cookedEncoding entries, then the data of each encoding. An encoding holds
+// each level in turn, largest first, and each level every face in turn.
+struct cookedHeader {
+  char Magic[4];
+  uint32_t Faces; // 1 for a 2D texture, 6 for a cubemap
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t Levels;
+  uint32_t NumEncodings;
+};
+
+struct cookedEncoding {
+  uint32_t Format; // GL internal format of the levels
+  uint32_t Reserved;
+  uint64_t Offset; // From the start of the file
+  uint64_t Size;
+};
+
+constexpr char CookedMagic[4] = {'G', 'S', 'T', '1'};
+// Encodings in the order the runtime prefers them
+constexpr GLenum CookedBC1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+constexpr GLenum CookedRGBA8 = GL_RGBA8;
+
+// Bytes of one face of a level, 0 for an unknown format
+size_t getCookedLevelSize(GLenum Format, unsigned Width, unsigned Height);
+bool isCookedCompressed(GLenum Format);
+
+// Read only mapping of a cooked texture file. The constructor only reads the
+// header and encoding table, as one encoding is uploaded of the several
+// stored, and prefetch() has that one read ahead from disk.
+struct cookedTexture {
+  // Throws if Path can't be mapped or isn't a valid cooked texture
+  explicit cookedTexture(const std::string &Path);
+  ~cookedTexture();
+
+  cookedTexture(const cookedTexture &) = delete;
+  cookedTexture &operator=(const cookedTexture &) = delete;
+  cookedTexture(cookedTexture &&Other);
+  cookedTexture &operator=(cookedTexture &&) = delete;
+
+  const cookedHeader &getHeader() const { return *MHeader; }
+  // Best encoding the GL implementation supports, which must follow
+  // glewInit(). RGBA8 is always supported but might not have been cooked.
+  const cookedEncoding *chooseEncoding() const;
+  // Asks for Encoding to be read ahead, so copying it out doesn't fault in
+  // its pages one at a time. Doesn't block.
+  void prefetch(const cookedEncoding &Encoding) const;
+  // Face of Level in Encoding, Size is set to its bytes
+  const unsigned char *getLevel(const cookedEncoding &Encoding, unsigned Level,
+                                unsigned Face, size_t &Size) const;
+
+private:
+  const unsigned char *MData;
+  size_t MSize;
+  const cookedHeader *MHeader;
+  const cookedEncoding *MEncodings;
+};
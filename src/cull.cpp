@@ -0,0 +1,148 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "cull.h"
+#include "trace.h"
+#include <cfloat>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Balls tested at once
+constexpr size_t SIMDWidth = 4;
+// Balls compacted by one task, a multiple of SIMDWidth
+constexpr size_t ChunkSize = 4096;
+// Work split across the pool, smaller jobs run on the calling thread
+constexpr size_t MinChunksPerThread = 4;
+
+// Appends the indices of the set bits of Mask, offset by Base, to Visible
+inline unsigned *appendVisible(unsigned Mask, unsigned Base,
+                               unsigned *Visible) {
+  while (Mask) {
+    *Visible++ = Base + __builtin_ctz(Mask);
+    Mask &= Mask - 1;
+  }
+  return Visible;
+}
+} // namespace
+
+frustum extractFrustum(const glm::mat4 &Clip) {
+  // Gribb and Hartmann, each plane is the sum or difference of the w row and
+  // one of the x, y and z rows. GLM matrices are column major.
+  glm::vec4 Rows[4];
+  for (unsigned R = 0; R < 4; R++) {
+    Rows[R] = glm::vec4(Clip[0][R], Clip[1][R], Clip[2][R], Clip[3][R]);
+  }
+
+  frustum F;
+  for (unsigned Axis = 0; Axis < 3; Axis++) {
+    F.Planes[Axis * 2] = Rows[3] + Rows[Axis];
+    F.Planes[Axis * 2 + 1] = Rows[3] - Rows[Axis];
+  }
+  for (glm::vec4 &Plane : F.Planes) {
+    Plane /= glm::length(glm::vec3(Plane));
+  }
+  return F;
+}
+
+ballCuller::ballCuller(std::vector<ballInstance> Balls, float Radius)
+    : MBalls(std::move(Balls)) {
+  const size_t NumChunks = (MBalls.size() + ChunkSize - 1) / ChunkSize;
+  const size_t Padded = NumChunks * ChunkSize;
+  // A negative radius fails every plane test
+  MX.assign(Padded, 0.0f);
+  MY.assign(Padded, 0.0f);
+  MZ.assign(Padded, 0.0f);
+  MRadius.assign(Padded, -FLT_MAX);
+  for (size_t i = 0; i < MBalls.size(); i++) {
+    MX[i] = MBalls[i].OffsetScale[0];
+    MY[i] = MBalls[i].OffsetScale[1];
+    MZ[i] = MBalls[i].OffsetScale[2];
+    MRadius[i] = MBalls[i].OffsetScale[3] * Radius;
+  }
+  MVisible.resize(Padded);
+  MChunkCounts.resize(NumChunks);
+}
+
+size_t ballCuller::cull(const glm::mat4 &Clip, workerPool &Pool,
+                        ballInstance *Out) {
+  TRACE_ZONE("cull balls");
+  const frustum F = extractFrustum(Clip);
+  const size_t NumChunks = MChunkCounts.size();
+
+  // Test every chunk, writing the indices of its visible balls to the start
+  // of the chunk's range of MVisible
+  Pool.run(NumChunks, MinChunksPerThread, [&](size_t Begin, size_t End) {
+    TRACE_ZONE("cull test");
+    for (size_t C = Begin; C < End; C++) {
+      const size_t First = C * ChunkSize;
+      unsigned *Visible = MVisible.data() + First;
+      unsigned *VisibleEnd = Visible;
+#if defined(__SSE2__)
+      __m128 Planes[6][4];
+      for (unsigned P = 0; P < 6; P++) {
+        for (unsigned K = 0; K < 4; K++) {
+          Planes[P][K] = _mm_set1_ps(F.Planes[P][K]);
+        }
+      }
+      for (size_t i = First; i < First + ChunkSize; i += SIMDWidth) {
+        const __m128 X = _mm_loadu_ps(&MX[i]);
+        const __m128 Y = _mm_loadu_ps(&MY[i]);
+        const __m128 Z = _mm_loadu_ps(&MZ[i]);
+        const __m128 NegRadius =
+            _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&MRadius[i]));
+        __m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (unsigned P = 0; P < 6; P++) {
+          __m128 Dist = _mm_add_ps(
+              _mm_add_ps(_mm_mul_ps(X, Planes[P][0]),
+                         _mm_mul_ps(Y, Planes[P][1])),
+              _mm_add_ps(_mm_mul_ps(Z, Planes[P][2]), Planes[P][3]));
+          Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Dist, NegRadius));
+        }
+        VisibleEnd = appendVisible(_mm_movemask_ps(Inside), i - First,
+                                   VisibleEnd);
+      }
+#else
+      for (size_t i = First; i < First + ChunkSize; i += SIMDWidth) {
+        unsigned Mask = 0;
+        for (unsigned L = 0; L < SIMDWidth; L++) {
+          const glm::vec3 Centre(MX[i + L], MY[i + L], MZ[i + L]);
+          bool Inside = true;
+          for (const glm::vec4 &Plane : F.Planes) {
+            Inside &= glm::dot(glm::vec3(Plane), Centre) + Plane.w >=
+                      -MRadius[i + L];
+          }
+          Mask |= unsigned(Inside) << L;
+        }
+        VisibleEnd = appendVisible(Mask, i - First, VisibleEnd);
+      }
+#endif
+      MChunkCounts[C] = VisibleEnd - Visible;
+    }
+  });
+
+  // Exclusive prefix sum turns the counts into offsets in Out
+  size_t NumVisible = 0;
+  for (size_t &Count : MChunkCounts) {
+    size_t ChunkVisible = Count;
+    Count = NumVisible;
+    NumVisible += ChunkVisible;
+  }
+
+  // Gather the visible balls of each chunk to its offset
+  Pool.run(NumChunks, MinChunksPerThread, [&](size_t Begin, size_t End) {
+    TRACE_ZONE("cull compact");
+    for (size_t C = Begin; C < End; C++) {
+      const size_t ChunkEnd =
+          C + 1 < NumChunks ? MChunkCounts[C + 1] : NumVisible;
+      const unsigned *Visible = MVisible.data() + C * ChunkSize;
+      const ballInstance *Balls = MBalls.data() + C * ChunkSize;
+      for (size_t Dst = MChunkCounts[C]; Dst < ChunkEnd; Dst++) {
+        std::memcpy(&Out[Dst], &Balls[*Visible++], sizeof(ballInstance));
+      }
+    }
+  });
+  return NumVisible;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include "balls.h"
+#include "workers.h"
+#include <glm/glm.hpp>
+#include <vector>
+// clang-format on
+
+// Planes of a view frustum as (normal, distance) with normals of unit length
+// facing inwards, so a point P is inside plane N when dot(N.xyz, P) + N.w >= 0
+struct frustum {
+  glm::vec4 Planes[6]; // left, right, bottom, top, near, far
+};
+
+// Extracts the planes of the frustum of a clip space transform, in the space
+// the transform maps from. E.g. the planes of a model view projection matrix
+// are in model space.
+frustum extractFrustum(const glm::mat4 &Clip);
+
+// Culls ball instances against a view frustum every frame. Centres and radii
+// are kept in structure of arrays layout so four balls are tested against
+// each plane at once, and the instance range is split across a worker pool.
+struct ballCuller {
+  // Radius is that of the sphere the balls scale
+  ballCuller(std::vector<ballInstance> Balls, float Radius);
+
+  // Writes the balls which intersect the frustum of the Clip transform
+  // contiguously to Out, which must have room for every ball, and returns
+  // how many were written. The order of the balls is preserved.
+  size_t cull(const glm::mat4 &Clip, workerPool &Pool, ballInstance *Out);
+
+  size_t getNumBalls() const { return MBalls.size(); }
+
+private:
+  std::vector<ballInstance> MBalls;
+  // Bounding spheres, padded to a multiple of the SIMD width with balls which
+  // are always culled
+  std::vector<float> MX;
+  std::vector<float> MY;
+  std::vector<float> MZ;
+  std::vector<float> MRadius;
+
+  // Indices of the visible balls of each chunk, from the chunk's first ball
+  std::vector<unsigned> MVisible;
+  // Visible balls of each chunk, then the offset of each chunk in Out
+  std::vector<size_t> MChunkCounts;
+};
@@ -0,0 +1,254 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#define GLSPHERE_GL_COUNTERS_IMPL
+#include "glcount.h"
+#include <fstream>
+#include <stdexcept>
+
+glCounter &glCounter::get() {
+  static glCounter Counter;
+  return Counter;
+}
+
+#ifdef GLSPHERE_GL_COUNTERS
+namespace {
+glCallStats &frame() { return glCounter::get().MCurrent; }
+
+// Primitives assembled from Count vertices
+unsigned long long getPrimitives(GLenum Mode, GLsizei Count) {
+  switch (Mode) {
+  case GL_POINTS:
+    return Count;
+  case GL_LINES:
+    return Count / 2;
+  case GL_LINE_STRIP:
+    return Count > 1 ? Count - 1 : 0;
+  case GL_TRIANGLES:
+    return Count / 3;
+  case GL_TRIANGLE_STRIP:
+  case GL_TRIANGLE_FAN:
+    return Count > 2 ? Count - 2 : 0;
+  case GL_PATCHES:
+    // The tessellation shaders take triangle patches
+    return Count / 3;
+  default:
+    return 0;
+  }
+}
+
+void countDraw(GLenum Mode, GLsizei Count, GLsizei Instances) {
+  glCallStats &Frame = frame();
+  Frame.CountedCalls++;
+  Frame.DrawCalls++;
+  Frame.Primitives += getPrimitives(Mode, Count) * Instances;
+}
+
+void countUniform() {
+  frame().CountedCalls++;
+  frame().UniformUpdates++;
+}
+
+// Entry points the wrappers forward to
+PFNGLUSEPROGRAMPROC RealUseProgram;
+PFNGLBINDVERTEXARRAYPROC RealBindVertexArray;
+PFNGLBINDBUFFERPROC RealBindBuffer;
+PFNGLBINDVERTEXBUFFERPROC RealBindVertexBuffer;
+PFNGLACTIVETEXTUREPROC RealActiveTexture;
+PFNGLBUFFERDATAPROC RealBufferData;
+PFNGLBUFFERSUBDATAPROC RealBufferSubData;
+PFNGLUNIFORM1FPROC RealUniform1f;
+PFNGLUNIFORM1IPROC RealUniform1i;
+PFNGLUNIFORM1UIPROC RealUniform1ui;
+PFNGLUNIFORM3FPROC RealUniform3f;
+PFNGLUNIFORMMATRIX4FVPROC RealUniformMatrix4fv;
+PFNGLDRAWARRAYSINSTANCEDPROC RealDrawArraysInstanced;
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC RealDrawElementsInstancedBaseVertex;
+PFNGLMULTIDRAWARRAYSPROC RealMultiDrawArrays;
+
+void GLAPIENTRY countUseProgram(GLuint Program) {
+  frame().CountedCalls++;
+  frame().ProgramBinds++;
+  RealUseProgram(Program);
+}
+
+void GLAPIENTRY countBindVertexArray(GLuint VAO) {
+  frame().CountedCalls++;
+  frame().VertexArrayBinds++;
+  RealBindVertexArray(VAO);
+}
+
+void GLAPIENTRY countBindBuffer(GLenum Target, GLuint Buffer) {
+  frame().CountedCalls++;
+  frame().BufferBinds++;
+  RealBindBuffer(Target, Buffer);
+}
+
+void GLAPIENTRY countBindVertexBuffer(GLuint Index, GLuint Buffer,
+                                      GLintptr Offset, GLsizei Stride) {
+  frame().CountedCalls++;
+  frame().BufferBinds++;
+  RealBindVertexBuffer(Index, Buffer, Offset, Stride);
+}
+
+void GLAPIENTRY countActiveTexture(GLenum Unit) {
+  frame().CountedCalls++;
+  RealActiveTexture(Unit);
+}
+
+void GLAPIENTRY countBufferData(GLenum Target, GLsizeiptr Size,
+                                const void *Data, GLenum Usage) {
+  frame().CountedCalls++;
+  // Only allocates when there's no data
+  if (Data) {
+    frame().UploadBytes += Size;
+  }
+  RealBufferData(Target, Size, Data, Usage);
+}
+
+void GLAPIENTRY countBufferSubData(GLenum Target, GLintptr Offset,
+                                   GLsizeiptr Size, const void *Data) {
+  frame().CountedCalls++;
+  frame().UploadBytes += Size;
+  RealBufferSubData(Target, Offset, Size, Data);
+}
+
+void GLAPIENTRY countUniform1f(GLint Location, GLfloat V0) {
+  countUniform();
+  RealUniform1f(Location, V0);
+}
+
+void GLAPIENTRY countUniform1i(GLint Location, GLint V0) {
+  countUniform();
+  RealUniform1i(Location, V0);
+}
+
+void GLAPIENTRY countUniform1ui(GLint Location, GLuint V0) {
+  countUniform();
+  RealUniform1ui(Location, V0);
+}
+
+void GLAPIENTRY countUniform3f(GLint Location, GLfloat V0, GLfloat V1,
+                               GLfloat V2) {
+  countUniform();
+  RealUniform3f(Location, V0, V1, V2);
+}
+
+void GLAPIENTRY countUniformMatrix4fv(GLint Location, GLsizei Count,
+                                      GLboolean Transpose,
+                                      const GLfloat *Value) {
+  countUniform();
+  RealUniformMatrix4fv(Location, Count, Transpose, Value);
+}
+
+void GLAPIENTRY countDrawArraysInstanced(GLenum Mode, GLint First,
+                                         GLsizei Count, GLsizei Instances) {
+  countDraw(Mode, Count, Instances);
+  RealDrawArraysInstanced(Mode, First, Count, Instances);
+}
+
+void GLAPIENTRY countDrawElementsInstancedBaseVertex(
+    GLenum Mode, GLsizei Count, GLenum Type, const void *Indices,
+    GLsizei Instances, GLint BaseVertex) {
+  countDraw(Mode, Count, Instances);
+  RealDrawElementsInstancedBaseVertex(Mode, Count, Type, Indices, Instances,
+                                      BaseVertex);
+}
+
+void GLAPIENTRY countMultiDrawArrays(GLenum Mode, const GLint *First,
+                                     const GLsizei *Count, GLsizei DrawCount) {
+  // One call, but the driver sees a draw per range
+  glCallStats &Frame = frame();
+  Frame.CountedCalls++;
+  Frame.DrawCalls++;
+  for (GLsizei i = 0; i < DrawCount; i++) {
+    Frame.Primitives += getPrimitives(Mode, Count[i]);
+  }
+  RealMultiDrawArrays(Mode, First, Count, DrawCount);
+}
+
+// Saves the GLEW pointer to forward to and replaces it with the wrapper
+template <typename T> void hook(T &GLEWPointer, T &Real, T Wrapper) {
+  if (GLEWPointer) {
+    Real = GLEWPointer;
+    GLEWPointer = Wrapper;
+  }
+}
+} // namespace
+
+void GLAPIENTRY countDrawArrays(GLenum Mode, GLint First, GLsizei Count) {
+  countDraw(Mode, Count, 1);
+  glDrawArrays(Mode, First, Count);
+}
+
+void GLAPIENTRY countDrawElements(GLenum Mode, GLsizei Count, GLenum Type,
+                                  const void *Indices) {
+  countDraw(Mode, Count, 1);
+  glDrawElements(Mode, Count, Type, Indices);
+}
+
+void GLAPIENTRY countBindTexture(GLenum Target, GLuint Texture) {
+  frame().CountedCalls++;
+  frame().TextureBinds++;
+  glBindTexture(Target, Texture);
+}
+
+void glCounter::install(bool RecordFrames) {
+  MRecord = RecordFrames;
+  hook(__glewUseProgram, RealUseProgram, countUseProgram);
+  hook(__glewBindVertexArray, RealBindVertexArray, countBindVertexArray);
+  hook(__glewBindBuffer, RealBindBuffer, countBindBuffer);
+  hook(__glewBindVertexBuffer, RealBindVertexBuffer, countBindVertexBuffer);
+  hook(__glewActiveTexture, RealActiveTexture, countActiveTexture);
+  hook(__glewBufferData, RealBufferData, countBufferData);
+  hook(__glewBufferSubData, RealBufferSubData, countBufferSubData);
+  hook(__glewUniform1f, RealUniform1f, countUniform1f);
+  hook(__glewUniform1i, RealUniform1i, countUniform1i);
+  hook(__glewUniform1ui, RealUniform1ui, countUniform1ui);
+  hook(__glewUniform3f, RealUniform3f, countUniform3f);
+  hook(__glewUniformMatrix4fv, RealUniformMatrix4fv, countUniformMatrix4fv);
+  hook(__glewDrawArraysInstanced, RealDrawArraysInstanced,
+       countDrawArraysInstanced);
+  hook(__glewDrawElementsInstancedBaseVertex,
+       RealDrawElementsInstancedBaseVertex,
+       countDrawElementsInstancedBaseVertex);
+  hook(__glewMultiDrawArrays, RealMultiDrawArrays, countMultiDrawArrays);
+}
+
+void glCounter::beginFrame() { MCurrent = {}; }
+
+void glCounter::endFrame() {
+  MLast = MCurrent;
+  MTotal.CountedCalls += MLast.CountedCalls;
+  MTotal.DrawCalls += MLast.DrawCalls;
+  MTotal.Primitives += MLast.Primitives;
+  MTotal.ProgramBinds += MLast.ProgramBinds;
+  MTotal.VertexArrayBinds += MLast.VertexArrayBinds;
+  MTotal.BufferBinds += MLast.BufferBinds;
+  MTotal.TextureBinds += MLast.TextureBinds;
+  MTotal.UniformUpdates += MLast.UniformUpdates;
+  MTotal.UploadBytes += MLast.UploadBytes;
+  MNumFrames++;
+  if (MRecord) {
+    MFrames.push_back(MLast);
+  }
+}
+
+void glCounter::writeCSV(const std::string &Path) const {
+  std::ofstream File(Path);
+  if (!File) {
+    throw std::runtime_error(std::string("Could not open GL call file ") +
+                             Path);
+  }
+  File << "frame,counted_calls,draw_calls,primitives,program_binds,"
+       << "vertex_array_binds,buffer_binds,texture_binds,uniform_updates,"
+       << "upload_bytes\n";
+  for (size_t i = 0; i < MFrames.size(); i++) {
+    const glCallStats &F = MFrames[i];
+    File << i << ',' << F.CountedCalls << ',' << F.DrawCalls << ','
+         << F.Primitives << ',' << F.ProgramBinds << ','
+         << F.VertexArrayBinds << ',' << F.BufferBinds << ','
+         << F.TextureBinds << ',' << F.UniformUpdates << ',' << F.UploadBytes
+         << '\n';
+  }
+}
+#endif
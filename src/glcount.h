@@ -0,0 +1,80 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+// clang-format on
+
+// GL calls made by one frame
+struct glCallStats {
+  // Calls to the entry points wrapped, see glCounter::install(). Others,
+  // such as glClear, texture uploads, mapping, syncs and queries, go
+  // uncounted so this isn't every GL call of the frame.
+  unsigned CountedCalls;
+  unsigned DrawCalls;
+  unsigned long long Primitives; // Upper bound for strips with restarts
+  unsigned ProgramBinds;
+  unsigned VertexArrayBinds;
+  unsigned BufferBinds;
+  unsigned TextureBinds;
+  unsigned UniformUpdates;
+  unsigned long long UploadBytes; // glBufferData and glBufferSubData
+};
+
+// Counts the GL calls of each frame by swapping the GLEW function pointers
+// for wrappers which tally a call then forward it. GL 1.1 entry points
+// aren't loaded by GLEW, so the ones used are redirected to wrappers by
+// macros in any file including this header.
+//
+// Only compiled in with GLSPHERE_GL_COUNTERS, which is off by default so
+// measurements aren't taken through the wrappers. Otherwise Enabled is false
+// and callers discard every use with if constexpr, so nothing is left behind.
+struct glCounter {
+#ifdef GLSPHERE_GL_COUNTERS
+  static constexpr bool Enabled = true;
+#else
+  static constexpr bool Enabled = false;
+#endif
+
+  static glCounter &get();
+
+  // Swaps the GLEW function pointers, must follow glewInit(). Every frame is
+  // kept for writeCSV() when RecordFrames is set.
+  void install(bool RecordFrames);
+
+  // Calls between the two are counted as one frame
+  void beginFrame();
+  void endFrame();
+
+  // Counts of the last frame ended
+  const glCallStats &getFrameStats() const { return MLast; }
+  const glCallStats &getTotalStats() const { return MTotal; }
+  unsigned long long getNumFrames() const { return MNumFrames; }
+
+  // One row per recorded frame
+  void writeCSV(const std::string &Path) const;
+
+  // Frame being counted, only for the wrappers
+  glCallStats MCurrent;
+
+private:
+  glCounter() : MCurrent{}, MLast{}, MTotal{}, MNumFrames(0), MRecord(false) {}
+
+  glCallStats MLast;
+  glCallStats MTotal;
+  unsigned long long MNumFrames;
+  bool MRecord;
+  std::vector<glCallStats> MFrames;
+};
+
+#if defined(GLSPHERE_GL_COUNTERS) && !defined(GLSPHERE_GL_COUNTERS_IMPL)
+void GLAPIENTRY countDrawArrays(GLenum Mode, GLint First, GLsizei Count);
+void GLAPIENTRY countDrawElements(GLenum Mode, GLsizei Count, GLenum Type,
+                                  const void *Indices);
+void GLAPIENTRY countBindTexture(GLenum Target, GLuint Texture);
+#define glDrawArrays countDrawArrays
+#define glDrawElements countDrawElements
+#define glBindTexture countBindTexture
+#endif
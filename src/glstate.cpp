@@ -0,0 +1,87 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "glstate.h"
+
+// Last, as it redirects GL 1.1 calls when counting them
+#include "glcount.h"
+
+namespace {
+// Never a valid name, so the first bind after invalidate() is issued
+constexpr GLuint Unknown = ~0u;
+} // namespace
+
+glState &glState::get() {
+  static glState State;
+  return State;
+}
+
+void glState::invalidate() {
+  MProgram = Unknown;
+  MVertexArray = Unknown;
+  MBuffers.fill(Unknown);
+  MActiveUnit = Unknown;
+  for (auto &Unit : MTextures) {
+    Unit.fill(Unknown);
+  }
+}
+
+bool glState::update(GLuint &Current, GLuint Value) {
+  if (Current == Value) {
+    MStats.Skipped++;
+    return false;
+  }
+  Current = Value;
+  MStats.Binds++;
+  return true;
+}
+
+void glState::useProgram(GLuint Program) {
+  if (update(MProgram, Program)) {
+    glUseProgram(Program);
+  }
+}
+
+void glState::bindVertexArray(GLuint VAO) {
+  if (update(MVertexArray, VAO)) {
+    glBindVertexArray(VAO);
+  }
+}
+
+void glState::bindBuffer(GLenum Target, GLuint Buffer) {
+  GLuint *Current = nullptr;
+  switch (Target) {
+  case GL_ARRAY_BUFFER:
+    Current = &MBuffers[ArrayBuffer];
+    break;
+  case GL_PIXEL_UNPACK_BUFFER:
+    Current = &MBuffers[PixelUnpackBuffer];
+    break;
+  default:
+    MStats.Binds++;
+    glBindBuffer(Target, Buffer);
+    return;
+  }
+  if (update(*Current, Buffer)) {
+    glBindBuffer(Target, Buffer);
+  }
+}
+
+void glState::bindTexture(unsigned Unit, GLenum Target, GLuint Texture) {
+  if (update(MActiveUnit, Unit)) {
+    glActiveTexture(GL_TEXTURE0 + Unit);
+  }
+
+  GLuint *Current = nullptr;
+  if (Unit < NumTextureUnits && Target == GL_TEXTURE_2D) {
+    Current = &MTextures[Unit][Texture2D];
+  } else if (Unit < NumTextureUnits && Target == GL_TEXTURE_CUBE_MAP) {
+    Current = &MTextures[Unit][TextureCubeMap];
+  } else {
+    MStats.Binds++;
+    glBindTexture(Target, Texture);
+    return;
+  }
+  if (update(*Current, Texture)) {
+    glBindTexture(Target, Texture);
+  }
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <array>
+// clang-format on
+
+// Binds since the last resetStats(), skipped ones matched the current state
+struct glStateStats {
+  unsigned Binds;
+  unsigned Skipped;
+};
+
+// Process wide cache of the GL bindings changed every frame, which skips any
+// bind matching what is already bound. Vertex attribute layouts are recorded
+// into vertex arrays once at load time, so a frame only binds programs,
+// vertex arrays, textures and the odd buffer.
+//
+// The cache starts out knowing nothing, and anything binding the same state
+// directly must call invalidate() afterwards.
+struct glState {
+  static glState &get();
+
+  void useProgram(GLuint Program);
+  void bindVertexArray(GLuint VAO);
+  // Not for GL_ELEMENT_ARRAY_BUFFER, which belongs to the vertex array
+  void bindBuffer(GLenum Target, GLuint Buffer);
+  // Also leaves Unit as the active texture unit
+  void bindTexture(unsigned Unit, GLenum Target, GLuint Texture);
+
+  // Forgets every binding, so the next bind of each is issued
+  void invalidate();
+
+  const glStateStats &getStats() const { return MStats; }
+  void resetStats() { MStats = {}; }
+
+  static constexpr unsigned NumTextureUnits = 4;
+
+private:
+  glState() : MStats{} { invalidate(); }
+
+  // Targets which are cached, others are always bound
+  enum bufferTarget : unsigned { ArrayBuffer, PixelUnpackBuffer, NumBuffers };
+  enum textureTarget : unsigned { Texture2D, TextureCubeMap, NumTextures };
+
+  // Issues the bind unless Current already matches, then records it
+  bool update(GLuint &Current, GLuint Value);
+
+  GLuint MProgram;
+  GLuint MVertexArray;
+  std::array<GLuint, NumBuffers> MBuffers;
+  GLuint MActiveUnit;
+  std::array<std::array<GLuint, NumTextures>, NumTextureUnits> MTextures;
+
+  glStateStats MStats;
+};
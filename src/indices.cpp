@@ -0,0 +1,171 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "indices.h"
+#include "trace.h"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+std::vector<unsigned> optimizeVertexCache(const std::vector<unsigned> &Indices,
+                                          size_t NumVertices,
+                                          unsigned CacheSize) {
+  TRACE_ZONE("optimizeVertexCache");
+  const size_t NumTriangles = Indices.size() / 3;
+
+  // Vertex to triangle adjacency in compressed rows, and the number of
+  // triangles using each vertex which haven't been emitted yet.
+  std::vector<unsigned> LiveCount(NumVertices, 0);
+  for (unsigned Idx : Indices) {
+    LiveCount[Idx]++;
+  }
+  std::vector<size_t> AdjOffset(NumVertices + 1, 0);
+  for (size_t V = 0; V < NumVertices; V++) {
+    AdjOffset[V + 1] = AdjOffset[V] + LiveCount[V];
+  }
+  std::vector<unsigned> AdjTriangles(Indices.size());
+  {
+    std::vector<size_t> Fill(AdjOffset.begin(), AdjOffset.end() - 1);
+    for (size_t T = 0; T < NumTriangles; T++) {
+      for (unsigned Corner = 0; Corner < 3; Corner++) {
+        AdjTriangles[Fill[Indices[T * 3 + Corner]]++] = T;
+      }
+    }
+  }
+
+  // Time each vertex last entered the cache
+  std::vector<long long> CacheTime(NumVertices, 0);
+  std::vector<bool> Emitted(NumTriangles, false);
+  std::vector<unsigned> DeadEnd;
+  std::vector<unsigned> Candidates;
+  std::vector<unsigned> Output;
+  Output.reserve(Indices.size());
+
+  long long Time = CacheSize + 1;
+  size_t Cursor = 0;
+  long long Fan = NumVertices ? 0 : -1;
+  while (Fan >= 0) {
+    // Emit all triangles around the fanning vertex
+    Candidates.clear();
+    for (size_t A = AdjOffset[Fan]; A < AdjOffset[Fan + 1]; A++) {
+      unsigned T = AdjTriangles[A];
+      if (Emitted[T]) {
+        continue;
+      }
+      for (unsigned Corner = 0; Corner < 3; Corner++) {
+        unsigned V = Indices[T * 3 + Corner];
+        Output.push_back(V);
+        DeadEnd.push_back(V);
+        Candidates.push_back(V);
+        LiveCount[V]--;
+        if (Time - CacheTime[V] > CacheSize) {
+          CacheTime[V] = Time++;
+        }
+      }
+      Emitted[T] = true;
+    }
+
+    // Next fanning vertex is the candidate still in the cache that entered
+    // it earliest, and will stay in the cache while its triangles are emitted
+    long long Next = -1;
+    long long BestPriority = -1;
+    for (unsigned V : Candidates) {
+      if (LiveCount[V] == 0) {
+        continue;
+      }
+      long long Priority = 0;
+      if (Time - CacheTime[V] + 2 * LiveCount[V] <= CacheSize) {
+        Priority = Time - CacheTime[V];
+      }
+      if (Priority > BestPriority) {
+        BestPriority = Priority;
+        Next = V;
+      }
+    }
+
+    // Dead end, fall back to recently used vertices, then in input order
+    while (Next < 0 && !DeadEnd.empty()) {
+      unsigned V = DeadEnd.back();
+      DeadEnd.pop_back();
+      if (LiveCount[V] > 0) {
+        Next = V;
+      }
+    }
+    while (Next < 0 && Cursor < NumVertices) {
+      if (LiveCount[Cursor] > 0) {
+        Next = Cursor;
+      }
+      Cursor++;
+    }
+    Fan = Next;
+  }
+  return Output;
+}
+
+double computeACMR(const std::vector<unsigned> &Indices, size_t NumVertices,
+                   GLenum Mode, unsigned CacheSize) {
+  // FIFO cache, a vertex is only inserted on a miss so it is evicted after
+  // CacheSize further misses. Tracking the miss count at insertion makes
+  // lookup constant time.
+  std::vector<long long> InsertedAt(NumVertices, -(long long)CacheSize - 1);
+  long long Misses = 0;
+  size_t Triangles = 0;
+  size_t StripLength = 0;
+  for (unsigned Idx : Indices) {
+    if (Idx == PrimitiveRestartIndex) {
+      StripLength = 0;
+      continue;
+    }
+
+    if (Misses - InsertedAt[Idx] >= CacheSize) {
+      InsertedAt[Idx] = Misses++;
+    }
+
+    StripLength++;
+    if (Mode == GL_TRIANGLE_STRIP && StripLength >= 3) {
+      Triangles++;
+    }
+  }
+  if (Mode == GL_TRIANGLES) {
+    Triangles = Indices.size() / 3;
+  }
+  return Triangles ? static_cast<double>(Misses) / Triangles : 0.0;
+}
+
+GLenum getIndexType(size_t NumVertices) {
+  // Largest 16-bit value is reserved for primitive restart
+  return (NumVertices < std::numeric_limits<uint16_t>::max())
+             ? GL_UNSIGNED_SHORT
+             : GL_UNSIGNED_INT;
+}
+
+indexBuffer buildIndexBuffer(const std::vector<unsigned> &Indices,
+                             size_t NumVertices, GLenum Mode, GLenum Type) {
+  TRACE_ZONE("buildIndexBuffer");
+  indexBuffer Buffer;
+  Buffer.Mode = Mode;
+  Buffer.Count = Indices.size();
+  Buffer.ACMRBefore = computeACMR(Indices, NumVertices, Mode);
+
+  // Strips are already emitted in cache friendly rows, only reorder lists
+  std::vector<unsigned> Optimized;
+  if (Mode == GL_TRIANGLES) {
+    Optimized = optimizeVertexCache(Indices, NumVertices);
+  }
+  const std::vector<unsigned> &Ordered =
+      (Mode == GL_TRIANGLES) ? Optimized : Indices;
+  Buffer.ACMRAfter = computeACMR(Ordered, NumVertices, Mode);
+
+  Buffer.Type = (Type == GL_NONE) ? getIndexType(NumVertices) : Type;
+  if (Buffer.Type == GL_UNSIGNED_SHORT) {
+    Buffer.Data.resize(Ordered.size() * sizeof(uint16_t));
+    uint16_t *Narrow = reinterpret_cast<uint16_t *>(Buffer.Data.data());
+    for (size_t i = 0; i < Ordered.size(); i++) {
+      // Truncation maps the 32-bit restart index to the 16-bit one
+      Narrow[i] = static_cast<uint16_t>(Ordered[i]);
+    }
+  } else {
+    Buffer.Data.resize(Ordered.size() * sizeof(unsigned));
+    std::memcpy(Buffer.Data.data(), Ordered.data(), Buffer.Data.size());
+  }
+  return Buffer;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <vector>
+// clang-format on
+
+// Marks the end of a triangle strip in 32-bit index lists, narrowed to the
+// maximum value of the index type when packed, which is what
+// GL_PRIMITIVE_RESTART_FIXED_INDEX expects.
+constexpr unsigned PrimitiveRestartIndex = 0xFFFFFFFF;
+
+// Post-transform vertex cache size assumed when optimizing and measuring
+constexpr unsigned VertexCacheSize = 16;
+
+// Index data ready to upload and draw with glDrawElements
+struct indexBuffer {
+  GLenum Mode;   // GL_TRIANGLES or GL_TRIANGLE_STRIP
+  GLenum Type;   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+  GLsizei Count; // Number of indices, including restart markers
+  std::vector<unsigned char> Data;
+
+  // Average cache miss ratio, transformed vertices per triangle, of the
+  // input and output ordering
+  double ACMRBefore;
+  double ACMRAfter;
+
+  size_t getSize() const { return Data.size(); }
+  const void *getData() const { return Data.data(); }
+  bool usesPrimitiveRestart() const { return Mode == GL_TRIANGLE_STRIP; }
+};
+
+// Reorders a triangle list to improve post-transform vertex cache hits using
+// the Tipsify algorithm from "Fast Triangle Reordering for Vertex Locality
+// and Reduced Overdraw", Sander et al. 2007.
+std::vector<unsigned> optimizeVertexCache(const std::vector<unsigned> &Indices,
+                                          size_t NumVertices,
+                                          unsigned CacheSize = VertexCacheSize);
+
+// Simulates a FIFO vertex cache and returns cache misses per triangle. Mode
+// is GL_TRIANGLES, or GL_TRIANGLE_STRIP with PrimitiveRestartIndex markers.
+double computeACMR(const std::vector<unsigned> &Indices, size_t NumVertices,
+                   GLenum Mode, unsigned CacheSize = VertexCacheSize);
+
+// Narrowest index type which can address NumVertices and still has a value
+// free for primitive restart
+GLenum getIndexType(size_t NumVertices);
+
+// Builds the index buffer for a mesh. Triangle lists are reordered for the
+// vertex cache, then indices are stored as Type, or if GL_NONE the narrowest
+// type from getIndexType().
+indexBuffer buildIndexBuffer(const std::vector<unsigned> &Indices,
+                             size_t NumVertices, GLenum Mode,
+                             GLenum Type = GL_NONE);
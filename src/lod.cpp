@@ -0,0 +1,160 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "lod.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace {
+// Sectors are chosen so that each spans at most this many pixels around the
+// silhouette
+constexpr float TargetEdgePixels = 4.0f;
+// Fraction below a coarser level's limit the radius must drop to switch to it
+constexpr float Hysteresis = 0.15f;
+// Coarsest tessellation generated
+constexpr unsigned MinStacks = 4;
+constexpr unsigned MinSectors = 8;
+} // namespace
+
+sphereLOD::sphereLOD(GLfloat Radius, unsigned NumSectors, unsigned NumStacks,
+                     unsigned NumLevels, vertexFormat Format,
+                     bool TriangleStrips, meshType Mesh)
+    : MRadius(Radius), MNumVertices(0), MCurrentLevel(0) {
+  TRACE_ZONE("sphereLOD::sphereLOD");
+  const GLenum Mode = TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+  GLenum Type = GL_NONE;
+
+  // Halve the stacks and sectors of each successive level
+  for (unsigned L = 0; L < std::max(1u, NumLevels); L++) {
+    unsigned Stacks = NumStacks >> L;
+    unsigned Sectors = NumSectors >> L;
+    if (L > 0 && (Stacks < MinStacks || Sectors < MinSectors)) {
+      break;
+    }
+
+    if (Format == vertexFormat::Procedural) {
+      // Vertices are generated by the vertex shader, nothing to build
+      lodLevel Level;
+      Level.Stacks = std::max(2u, Stacks);
+      Level.Sectors = std::max(2u, Sectors);
+      Level.Description = "uv " + std::to_string(Level.Stacks) + "x" +
+                          std::to_string(Level.Sectors);
+      Level.BaseVertex = 0;
+      Level.IndexOffset = 0;
+      Level.IndexCount = 0;
+      Level.NumTriangles = getUVTriangles(Level.Sectors, Level.Stacks);
+      Level.MaxError = std::numeric_limits<float>::quiet_NaN();
+      Level.MaxPixelRadius =
+          (L == 0) ? std::numeric_limits<float>::infinity()
+                   : TargetEdgePixels * Level.Sectors / (2.0f * M_PI);
+      MLevels.push_back(Level);
+      continue;
+    }
+
+    sphere Sphere(Radius, Sectors, Stacks, Mesh);
+    lodLevel Level;
+    Level.Stacks = Sphere.getNumStacks();
+    Level.Sectors = Sphere.getNumSectors();
+    Level.Description = Sphere.getDescription();
+    Level.BaseVertex = MNumVertices;
+    Level.NumTriangles = Sphere.getNumTriangles();
+    Level.MaxError = Sphere.getMaxError();
+    // The finest level is used however large the sphere gets. Icospheres and
+    // cube-spheres have about as many triangles as the UV sphere of the same
+    // sectors, so have similar edge lengths.
+    Level.MaxPixelRadius =
+        (L == 0) ? std::numeric_limits<float>::infinity()
+                 : TargetEdgePixels * Level.Sectors / (2.0f * M_PI);
+
+    if (Format == vertexFormat::Packed) {
+      std::vector<packedVertex> Packed = Sphere.getPackedVertices();
+      MPacked.insert(MPacked.end(), Packed.begin(), Packed.end());
+    } else {
+      MVertices.insert(MVertices.end(), Sphere.getVertexData(),
+                       Sphere.getVertexData() + Sphere.getVertexSize() /
+                                                    sizeof(GLfloat));
+      MNormals.insert(MNormals.end(), Sphere.getNormalData(),
+                      Sphere.getNormalData() +
+                          Sphere.getNormalSize() / sizeof(GLfloat));
+      MTexCoords.insert(MTexCoords.end(), Sphere.getTexCoordData(),
+                        Sphere.getTexCoordData() +
+                            Sphere.getTexCoordSize() / sizeof(GLfloat));
+    }
+    MNumVertices += Sphere.getNumVertices();
+
+    // The finest level has the most vertices, so decides the shared type
+    indexBuffer Indices = buildIndexBuffer(TriangleStrips
+                                               ? Sphere.getStripIndices()
+                                               : Sphere.getIndices(),
+                                           Sphere.getNumVertices(), Mode, Type);
+    if (L == 0) {
+      Type = Indices.Type;
+      MIndices.ACMRBefore = Indices.ACMRBefore;
+      MIndices.ACMRAfter = Indices.ACMRAfter;
+    }
+    Level.IndexOffset = MIndices.Data.size();
+    Level.IndexCount = Indices.Count;
+    MIndices.Data.insert(MIndices.Data.end(), Indices.Data.begin(),
+                         Indices.Data.end());
+
+    MLevels.push_back(Level);
+  }
+
+  MIndices.Mode = Mode;
+  MIndices.Type = Type;
+  MIndices.Count = 0;
+  for (const lodLevel &Level : MLevels) {
+    MIndices.Count += Level.IndexCount;
+  }
+}
+
+void sphereLOD::freeData() {
+  // swap rather than clear() so the capacity is released
+  std::vector<packedVertex>().swap(MPacked);
+  std::vector<GLfloat>().swap(MVertices);
+  std::vector<GLfloat>().swap(MNormals);
+  std::vector<GLfloat>().swap(MTexCoords);
+  std::vector<unsigned char>().swap(MIndices.Data);
+}
+
+unsigned sphereLOD::selectLevel(float PixelRadius) {
+  const unsigned NumLevels = MLevels.size();
+
+  // Coarsest level without hysteresis
+  unsigned Desired = 0;
+  while (Desired + 1 < NumLevels &&
+         MLevels[Desired + 1].MaxPixelRadius >= PixelRadius) {
+    Desired++;
+  }
+
+  if (Desired < MCurrentLevel) {
+    // Current level is too coarse, refine immediately
+    MCurrentLevel = Desired;
+  } else if (Desired > MCurrentLevel) {
+    while (MCurrentLevel + 1 < NumLevels &&
+           MLevels[MCurrentLevel + 1].MaxPixelRadius * (1.0f - Hysteresis) >=
+               PixelRadius) {
+      MCurrentLevel++;
+    }
+  }
+  return MCurrentLevel;
+}
+
+float getProjectedRadius(const glm::vec3 &Center, float Radius,
+                         const glm::vec3 &CameraPos, const glm::mat4 &Proj,
+                         int ViewportHeight) {
+  const glm::vec3 ToCenter = Center - CameraPos;
+  const float DistSquared = glm::dot(ToCenter, ToCenter);
+  const float RadiusSquared = Radius * Radius;
+  if (DistSquared <= RadiusSquared) {
+    // Camera is inside the sphere
+    return std::numeric_limits<float>::infinity();
+  }
+
+  // Tangent of the angle subtended by the radius, scaled by the projection's
+  // cot(fovy / 2) into normalized device coordinates, then into pixels
+  const float TanAngle = Radius / std::sqrt(DistSquared - RadiusSquared);
+  return TanAngle * Proj[1][1] * (ViewportHeight * 0.5f);
+}
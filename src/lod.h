@@ -0,0 +1,79 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include "indices.h"
+#include "sphere.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+// clang-format on
+
+// Range of the shared sphere buffers drawn for one level of detail. With
+// vertexFormat::Procedural there are no buffers, only the tessellation.
+struct lodLevel {
+  unsigned Stacks;
+  unsigned Sectors;
+  std::string Description; // Mesh type and tessellation
+  GLint BaseVertex;     // First vertex of the level in the vertex buffers
+  size_t IndexOffset;   // Byte offset of the first index of the level
+  GLsizei IndexCount;   // Number of indices, including restart markers
+  size_t NumTriangles;  // Non-degenerate triangles
+  float MaxError;       // Largest distance from the true sphere, NaN if
+                        // there is no mesh to measure
+  float MaxPixelRadius; // Largest projected radius the level is good for
+};
+
+// A sphere tessellated at several levels of detail, finest first. Vertices
+// and indices of every level are concatenated so that they can be uploaded to
+// a single set of buffers and drawn with glDrawElementsBaseVertex.
+struct sphereLOD {
+  sphereLOD(GLfloat Radius, unsigned NumSectors, unsigned NumStacks,
+            unsigned NumLevels, vertexFormat Format, bool TriangleStrips,
+            meshType Mesh = meshType::UV);
+
+  unsigned getNumLevels() const { return MLevels.size(); }
+  const lodLevel &getLevel(unsigned Level) const { return MLevels[Level]; }
+  size_t getNumVertices() const { return MNumVertices; }
+  GLfloat getRadius() const { return MRadius; }
+  glm::mat4 getModelMatrix() const { return glm::mat4(1.f); }
+
+  // Only populated for vertexFormat::Packed
+  const std::vector<packedVertex> &getPackedVertices() const {
+    return MPacked;
+  }
+  // Only populated for vertexFormat::Float
+  const std::vector<GLfloat> &getVertices() const { return MVertices; }
+  const std::vector<GLfloat> &getNormals() const { return MNormals; }
+  const std::vector<GLfloat> &getTexCoords() const { return MTexCoords; }
+
+  // Indices of all levels, type is shared and ACMR is of the finest level
+  const indexBuffer &getIndexBuffer() const { return MIndices; }
+
+  // Release CPU copies of vertex and index data once uploaded
+  void freeData();
+
+  // Picks the coarsest level good enough for a projected radius in pixels.
+  // Switching to a coarser level requires the radius to drop a margin below
+  // that level's limit, to avoid popping back and forth at the boundary.
+  unsigned selectLevel(float PixelRadius);
+  unsigned getCurrentLevel() const { return MCurrentLevel; }
+
+private:
+  GLfloat MRadius;
+  size_t MNumVertices;
+  unsigned MCurrentLevel;
+  std::vector<lodLevel> MLevels;
+
+  std::vector<packedVertex> MPacked;
+  std::vector<GLfloat> MVertices;
+  std::vector<GLfloat> MNormals;
+  std::vector<GLfloat> MTexCoords;
+  indexBuffer MIndices;
+};
+
+// Radius in pixels of a sphere projected with a perspective matrix onto a
+// viewport ViewportHeight pixels high.
+float getProjectedRadius(const glm::vec3 &Center, float Radius,
+                         const glm::vec3 &CameraPos, const glm::mat4 &Proj,
+                         int ViewportHeight);
@@ -2,19 +2,86 @@
 
 // clang-format off
 #include "shaders.h"
+#include "assets.h"
 #include "sphere.h"
 #include "controls.h"
+#include "indices.h"
+#include "lod.h"
+#include "balls.h"
+#include "cull.h"
+#include "glstate.h"
+#include "occlusion.h"
 #include "skybox.h"
+#include "stream.h"
 #include "text.h"
+#include "timers.h"
+#include "trace.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+// Last, as it redirects GL 1.1 calls when counting them
+#include "glcount.h"
 // clang-format on
 
+struct options {
+  // Default number of Stacks and Sectors
+  unsigned Sectors = 36;
+  unsigned Stacks = 18;
+  // Render offscreen into a framebuffer object without a visible window
+  bool Headless = false;
+  // Number of frames to render before exiting, 0 runs until escape is pressed
+  unsigned Frames = 0;
+  // Sphere vertex buffer layout, or none when generated in the shader
+  vertexFormat VertexFormat = vertexFormat::Float;
+  // Tessellation of the sphere surface
+  meshType Mesh = meshType::UV;
+  // Draw sphere stacks as triangle strips rather than a triangle list
+  bool TriangleStrips = false;
+  // Number of sphere levels of detail, each halving the stacks and sectors
+  unsigned LODLevels = 1;
+  // Ray-cast the sphere on a camera facing quad rather than drawing a mesh
+  bool Impostor = false;
+  // Refine an icosahedron with tessellation shaders rather than drawing a mesh
+  bool Tessellation = false;
+  // Number of sphere instances drawn
+  unsigned Balls = 1;
+  // Draw only the balls which intersect the view frustum
+  bool Cull = true;
+  // Threads culling balls, 0 uses every hardware thread
+  unsigned CullThreads = 0;
+  // Also hide balls behind the nearest balls with a CPU depth buffer
+  bool Occlusion = false;
+  // Stream culled balls through a persistently mapped buffer when supported
+  bool PersistentMap = true;
+  // File to write per pass timing statistics to on exit, empty if disabled
+  std::string StatsPath;
+  // File to write a Chrome trace of CPU zones to on exit, empty if disabled
+  std::string TracePath;
+  // File to write per frame GL call counts to on exit, empty if disabled
+  std::string GLCallsPath;
+  // Directory caching linked shader program binaries, empty if disabled
+  std::string ShaderCacheDir = "shader_cache";
+  // Upload every texture before the first frame rather than drawing
+  // placeholders until each is decoded
+  bool SyncAssets = false;
+  // Load textures cooked by glsphere_cook when present, rather than decoding
+  // their sources
+  bool CookedTextures = true;
+};
+
 void printUsage(std::string Name) {
   std::cout << "Usage: " << Name << std::endl
             << "OpenGL implementation of a sphere in a skybox." << std::endl
@@ -25,10 +92,50 @@ void printUsage(std::string Name) {
             << "\t--stacks N \t\tNumber of stacks in sphere, defaults to 18"
             << std::endl
             << "\t--sectors N \t\tNumber of sectors in sphere, defaults to 36"
-            << std::endl;
+            << std::endl
+            << "\t--vertex-format F \tSphere vertex format, \"float\" "
+            << "(default), \"packed\" or \"procedural\"" << std::endl
+            << "\t--mesh M \t\tSphere tessellation, \"uv\" (default), "
+            << "\"ico\" or \"cube\"" << std::endl
+            << "\t--triangle-strips \tDraw sphere as triangle strips with "
+            << "primitive restart" << std::endl
+            << "\t--lod N \t\tNumber of sphere levels of detail selected by "
+            << "screen size, defaults to 1" << std::endl
+            << "\t--impostor \t\tRay-cast the sphere in the fragment shader "
+            << "instead of drawing a mesh" << std::endl
+            << "\t--tessellation \tRefine an icosahedron in tessellation "
+            << "shaders instead of drawing a mesh" << std::endl
+            << "\t--balls N \t\tDraw N instances of the sphere in a grid, "
+            << "defaults to 1" << std::endl
+            << "\t--no-cull \t\tDraw every ball rather than only those in "
+            << "view" << std::endl
+            << "\t--cull-threads N \tThreads culling balls, defaults to one "
+            << "per hardware thread" << std::endl
+            << "\t--occlusion \t\tAlso skip balls hidden behind the nearest "
+            << "balls, tested on the CPU" << std::endl
+            << "\t--no-persistent-map \tStream culled balls by mapping "
+            << "ranges each frame rather than persistently" << std::endl
+            << "\t--headless \t\tRender offscreen without a visible window, "
+            << "requires --frames" << std::endl
+            << "\t--frames N \t\tExit after rendering N frames and print "
+            << "timing statistics" << std::endl
+            << "\t--stats FILE \t\tWrite per pass frame time percentiles "
+            << "to a JSON file on exit" << std::endl
+            << "\t--trace FILE \t\tWrite a Chrome trace of CPU zones to a "
+            << "JSON file on exit" << std::endl
+            << "\t--gl-calls FILE \tWrite per frame GL call counts to a CSV "
+            << "file on exit" << std::endl
+            << "\t--shader-cache DIR \tCache linked shader programs in DIR, "
+            << "defaults to shader_cache" << std::endl
+            << "\t--no-shader-cache \tCompile every shader program from "
+            << "source" << std::endl
+            << "\t--sync-assets \t\tLoad every texture before the first "
+            << "frame" << std::endl
+            << "\t--no-cooked-textures \tDecode texture sources rather than "
+            << "loading cooked textures" << std::endl;
 }
 
-int parseCLI(int argc, char *argv[], unsigned &Sectors, unsigned &Stacks) {
+int parseCLI(int argc, char *argv[], options &Opts) {
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     if ((arg == "-h") || (arg == "--help")) {
@@ -37,7 +144,7 @@ int parseCLI(int argc, char *argv[], unsigned &Sectors, unsigned &Stacks) {
     } else if (arg == "--stacks") {
       if (i + 1 < argc) {
         i++;
-        Stacks = std::atoi(argv[i]);
+        Opts.Stacks = std::atoi(argv[i]);
       } else {
         std::cout << "Error: --stacks CLI requires an argument" << std::endl;
         return -1;
@@ -45,18 +152,203 @@ int parseCLI(int argc, char *argv[], unsigned &Sectors, unsigned &Stacks) {
     } else if (arg == "--sectors") {
       if (i + 1 < argc) {
         i++;
-        Sectors = std::atoi(argv[i]);
+        Opts.Sectors = std::atoi(argv[i]);
       } else {
         std::cout << "Error: --sectors CLI requires an argument" << std::endl;
         printUsage(argv[0]);
         return -1;
       }
+    } else if (arg == "--vertex-format") {
+      if (i + 1 < argc) {
+        i++;
+        std::string Format = argv[i];
+        if (Format == "float") {
+          Opts.VertexFormat = vertexFormat::Float;
+        } else if (Format == "packed") {
+          Opts.VertexFormat = vertexFormat::Packed;
+        } else if (Format == "procedural") {
+          Opts.VertexFormat = vertexFormat::Procedural;
+        } else {
+          std::cout << "Error: Unknown vertex format \"" << Format << "\""
+                    << std::endl;
+          printUsage(argv[0]);
+          return -1;
+        }
+      } else {
+        std::cout << "Error: --vertex-format CLI requires an argument"
+                  << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--mesh") {
+      if (i + 1 < argc) {
+        i++;
+        std::string Mesh = argv[i];
+        if (Mesh == "uv") {
+          Opts.Mesh = meshType::UV;
+        } else if (Mesh == "ico") {
+          Opts.Mesh = meshType::Ico;
+        } else if (Mesh == "cube") {
+          Opts.Mesh = meshType::Cube;
+        } else {
+          std::cout << "Error: Unknown mesh \"" << Mesh << "\"" << std::endl;
+          printUsage(argv[0]);
+          return -1;
+        }
+      } else {
+        std::cout << "Error: --mesh CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--triangle-strips") {
+      Opts.TriangleStrips = true;
+    } else if (arg == "--lod") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.LODLevels = std::atoi(argv[i]);
+      } else {
+        std::cout << "Error: --lod CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--impostor") {
+      Opts.Impostor = true;
+    } else if (arg == "--tessellation") {
+      Opts.Tessellation = true;
+    } else if (arg == "--balls") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.Balls = std::atoi(argv[i]);
+      } else {
+        std::cout << "Error: --balls CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--no-cull") {
+      Opts.Cull = false;
+    } else if (arg == "--cull-threads") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.CullThreads = std::atoi(argv[i]);
+      } else {
+        std::cout << "Error: --cull-threads CLI requires an argument"
+                  << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--occlusion") {
+      Opts.Occlusion = true;
+    } else if (arg == "--no-persistent-map") {
+      Opts.PersistentMap = false;
+    } else if (arg == "--headless") {
+      Opts.Headless = true;
+    } else if (arg == "--frames") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.Frames = std::atoi(argv[i]);
+      } else {
+        std::cout << "Error: --frames CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--stats") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.StatsPath = argv[i];
+      } else {
+        std::cout << "Error: --stats CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--trace") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.TracePath = argv[i];
+      } else {
+        std::cout << "Error: --trace CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--shader-cache") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.ShaderCacheDir = argv[i];
+      } else {
+        std::cout << "Error: --shader-cache CLI requires an argument"
+                  << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
+    } else if (arg == "--no-shader-cache") {
+      Opts.ShaderCacheDir.clear();
+    } else if (arg == "--sync-assets") {
+      Opts.SyncAssets = true;
+    } else if (arg == "--no-cooked-textures") {
+      Opts.CookedTextures = false;
+    } else if (arg == "--gl-calls") {
+      if (i + 1 < argc) {
+        i++;
+        Opts.GLCallsPath = argv[i];
+      } else {
+        std::cout << "Error: --gl-calls CLI requires an argument" << std::endl;
+        printUsage(argv[0]);
+        return -1;
+      }
     } else {
       std::cout << "Error: Unknown CLI argument \"" << arg << "\"" << std::endl;
       printUsage(argv[0]);
       return -1;
     }
   }
+
+  if (!glCounter::Enabled && !Opts.GLCallsPath.empty()) {
+    std::cout << "Error: --gl-calls requires building with "
+              << "GLSPHERE_GL_COUNTERS" << std::endl;
+    return -1;
+  }
+
+  if (Opts.Headless && Opts.Frames == 0) {
+    std::cout << "Error: --headless requires a non-zero --frames count"
+              << std::endl;
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  if (Opts.TriangleStrips && Opts.Mesh != meshType::UV) {
+    std::cout << "Error: --triangle-strips requires --mesh uv" << std::endl;
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  if (Opts.Impostor && Opts.Tessellation) {
+    std::cout << "Error: --impostor and --tessellation can't be combined"
+              << std::endl;
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  if (Opts.Balls == 0 ||
+      (Opts.Balls > 1 && (Opts.Impostor || Opts.Tessellation))) {
+    std::cout << "Error: --balls requires a non-zero count and the sphere mesh"
+              << std::endl;
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  if (Opts.Occlusion && (Opts.Balls == 1 || !Opts.Cull)) {
+    std::cout << "Error: --occlusion requires --balls greater than 1 and "
+              << "culling" << std::endl;
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  if (Opts.VertexFormat == vertexFormat::Procedural &&
+      (Opts.Mesh != meshType::UV || Opts.TriangleStrips)) {
+    std::cout << "Error: --vertex-format procedural only draws a --mesh uv "
+              << "triangle list" << std::endl;
+    printUsage(argv[0]);
+    return -1;
+  }
   return 1;
 }
 
@@ -139,19 +431,32 @@ void APIENTRY glDebugOutput(GLenum Source, GLenum Type, unsigned int ID,
 }
 
 int main(int argc, char *argv[]) {
-  // Default number of Stacks and Sectors
-  unsigned Sectors = 36;
-  unsigned Stacks = 18;
-
-  if (int Ret = parseCLI(argc, argv, Sectors, Stacks); Ret < 1) {
+  options Opts;
+  if (int Ret = parseCLI(argc, argv, Opts); Ret < 1) {
     return Ret;
   }
 
+  if (!Opts.TracePath.empty()) {
+    tracer::get().enable();
+  }
+  scopedZone StartupZone("startup");
+  const auto LaunchTime = std::chrono::steady_clock::now();
+
+  // Asset files are read and decoded on worker threads while the context is
+  // created, and textures drawn with placeholders until they are uploaded
+  assetLoader Assets;
+  std::future<std::vector<unsigned char>> FontFile =
+      Assets.readFile("fonts/FreeSans.ttf");
+  textureFiles SkyboxFiles = skybox::loadCubemap(Assets, Opts.CookedTextures);
+  textureFiles SphereFiles = sphere::loadTexture(Assets, Opts.CookedTextures);
+
   // Initialize GLFW
+  scopedZone GLFWZone("glfwInit");
   if (!glfwInit()) {
     std::cerr << "Failed to initialize GLFW" << std::endl;
     return -1;
   }
+  GLFWZone.end();
 
   glfwWindowHint(GLFW_SAMPLES, 4);
   // 4.3 so we can use debug context
@@ -161,6 +466,11 @@ int main(int argc, char *argv[]) {
 #ifndef NDEBUG
   glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
 #endif
+  if (Opts.Headless) {
+    // Context is still backed by a window, but it is never shown and all
+    // rendering goes to an offscreen framebuffer object
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  }
 
   // Open a window and create its OpenGL context
   const int WindowWidth = 1024;
@@ -175,12 +485,17 @@ int main(int argc, char *argv[]) {
   glfwMakeContextCurrent(Window);
 
   // Initialize GLEW
+  scopedZone GLEWZone("glewInit");
   glewExperimental = true;
   if (glewInit() != GLEW_OK) {
     std::cerr << "Failed to initialize GLEW" << std::endl;
     glfwTerminate();
     return -1;
   }
+  GLEWZone.end();
+  if constexpr (glCounter::Enabled) {
+    glCounter::get().install(!Opts.GLCallsPath.empty());
+  }
 
 #ifndef NDEBUG
   std::cout << "GL version " << glGetString(GL_VERSION) << std::endl;
@@ -199,14 +514,74 @@ int main(int argc, char *argv[]) {
                           GL_TRUE);
   }
 
-  // Ensure we can capture the escape key being pressed to exit
-  glfwSetInputMode(Window, GLFW_STICKY_KEYS, GL_TRUE);
-  // Hide the mouse and enable unlimited movement
-  glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  if (!Opts.Headless) {
+    // Ensure we can capture the escape key being pressed to exit
+    glfwSetInputMode(Window, GLFW_STICKY_KEYS, GL_TRUE);
+    // Hide the mouse and enable unlimited movement
+    glfwSetInputMode(Window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // Set the mouse at the center of the screen
+    glfwPollEvents();
+    glfwSetCursorPos(Window, WindowWidth / 2, WindowHeight / 2);
+  }
+
+  /*
+    Offscreen framebuffer GL objects, only used in headless mode
+  */
+  GLuint OffscreenFBO = 0;
+  GLuint OffscreenColorRBO = 0;
+  GLuint OffscreenDepthRBO = 0;
+  if (Opts.Headless) {
+    glGenFramebuffers(1, &OffscreenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, OffscreenFBO);
+
+    glGenRenderbuffers(1, &OffscreenColorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, OffscreenColorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WindowWidth,
+                          WindowHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, OffscreenColorRBO);
+
+    glGenRenderbuffers(1, &OffscreenDepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, OffscreenDepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WindowWidth,
+                          WindowHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, OffscreenDepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+      glfwTerminate();
+      return -1;
+    }
+    glViewport(0, 0, WindowWidth, WindowHeight);
+  }
+
+  // Relaunching skips compiling programs which haven't changed
+  setShaderCache(Opts.ShaderCacheDir);
 
-  // Set the mouse at the center of the screen
-  glfwPollEvents();
-  glfwSetCursorPos(Window, WindowWidth / 2, WindowHeight / 2);
+  // Every program is started before anything else is set up, so drivers
+  // which compile on their own threads overlap it with the glyph, texture
+  // and mesh setup below. Each is only checked when first used.
+  enableParallelShaderCompile();
+  shaderProgram TextShaders, SkyboxShaders, SphereShaders, ImpostorShaders,
+      TessShaders;
+  try {
+    TextShaders = startTextShaders();
+    SkyboxShaders = startSkyboxShaders();
+    SphereShaders = startSphereShaders();
+    if (Opts.Impostor) {
+      ImpostorShaders = startSphereImpostorShaders();
+    }
+    if (Opts.Tessellation) {
+      TessShaders = startSphereTessellationShaders();
+    }
+  } catch (std::exception &E) {
+    std::cerr << "Error " << E.what() << std::endl;
+    glfwTerminate();
+    return -1;
+  }
 
   // Dark blue background
   glClearColor(0.0f, 0.0f, 0.4f, 0.0f);
@@ -220,52 +595,41 @@ int main(int argc, char *argv[]) {
   /*
     Text GL objects
   */
-  text Text; // Init glyph textures
+  // Init empty glyph atlas, loading the font rethrows any read error
+  std::unique_ptr<text> TextPtr;
+  try {
+    TextPtr = std::make_unique<text>(FontFile.get());
+  } catch (std::exception &E) {
+    std::cerr << "Error " << E.what() << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  text &Text = *TextPtr;
 
   // Create and bind text Vertex Array Object (VA0)
   GLuint TextVAO;
   glGenVertexArrays(1, &TextVAO);
   glBindVertexArray(TextVAO);
 
-  // Create and bind text Vertex Buffer Object (VBO)
+  // Create text Vertex Buffer Object (VBO), text::draw() allocates storage
+  // for the quads of every label
   GLuint TextVBO;
   glGenBuffers(1, &TextVBO);
   glBindBuffer(GL_ARRAY_BUFFER, TextVBO);
 
-  // 2D quad requires 6 vertices of 4 floats each
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+  // Position and texture coordinate of each vertex as a vec4
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
-  GLuint TextProgram;
-  try {
-    TextProgram = loadTextShaders();
-  } catch (std::exception &E) {
-    std::cerr << "Error " << E.what() << std::endl;
-    glfwTerminate();
-    return -1;
-  }
-  glm::mat4 TextProjMatrix = glm::ortho(0.0f, static_cast<float>(WindowWidth),
-                                        0.0f, static_cast<float>(WindowHeight));
-  GLuint TextMVPUniform = glGetUniformLocation(TextProgram, "MVP");
-  GLuint TextColorUniform = glGetUniformLocation(TextProgram, "TextColor");
-  glUseProgram(TextProgram);
-  glUniformMatrix4fv(TextMVPUniform, 1, GL_FALSE,
-                     glm::value_ptr(TextProjMatrix));
-
   /*
     Skybox GL objects
   */
   skybox Skybox;
-  unsigned int SkyboxTexture;
-  try {
-    SkyboxTexture = Skybox.loadCubemap();
-  } catch (std::exception &E) {
-    std::cerr << "Error " << E.what() << std::endl;
-    glfwTerminate();
-    return -1;
-  }
+  // Background colour, so the sky is only missing rather than wrong
+  asyncTexture SkyboxTexture(GL_TEXTURE_CUBE_MAP, std::move(SkyboxFiles),
+                             {0, 0, 102, 255}, false /* mipmaps */);
 
   // Create and bind skybox Vertex Array Object (VA0)
   GLuint SkyboxVAO;
@@ -290,67 +654,239 @@ int main(int argc, char *argv[]) {
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, Skybox.getIndexSize(),
                Skybox.getIndexData(), GL_STATIC_DRAW);
 
-  GLuint SkyboxProgram;
-  try {
-    SkyboxProgram = loadSkyboxShaders();
-  } catch (std::exception &E) {
-    std::cerr << "Error " << E.what() << std::endl;
-    glfwTerminate();
-    return -1;
-  }
-  GLuint SkyboxMVPUniform = glGetUniformLocation(SkyboxProgram, "MVP");
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0,        // Matches shader layer
+                        3,        // matches vec3
+                        GL_FLOAT, // type
+                        GL_FALSE, // normalized?
+                        0,        // stride, 0 lets GL decide
+                        (void *)0 // array buffer offset
+  );
 
   /*
     Sphere GL objects
   */
-  sphere Sphere(1.0f /* radius */, Sectors, Stacks);
-  unsigned int SphereTexture;
+  // Impostors are ray-cast in the fragment shader and tessellation builds its
+  // own small base mesh, so neither needs the sphere buffers
+  const bool SphereMesh = !Opts.Impostor && !Opts.Tessellation;
+  const vertexFormat SphereFormat =
+      SphereMesh ? Opts.VertexFormat : vertexFormat::Procedural;
+  std::unique_ptr<sphereLOD> SphereLevels;
   try {
-    SphereTexture = Sphere.loadTexture();
+    SphereLevels = std::make_unique<sphereLOD>(
+        1.0f /* radius */, Opts.Sectors, Opts.Stacks, Opts.LODLevels,
+        SphereFormat, Opts.TriangleStrips, Opts.Mesh);
   } catch (std::exception &E) {
     std::cerr << "Error " << E.what() << std::endl;
     glfwTerminate();
     return -1;
   }
+  sphereLOD &Sphere = *SphereLevels;
+  const bool Procedural = SphereFormat == vertexFormat::Procedural;
+  for (unsigned L = 0; SphereMesh && L < Sphere.getNumLevels(); L++) {
+    const lodLevel &Level = Sphere.getLevel(L);
+    std::cout << "Sphere LOD " << L << ": " << Level.Description << ", "
+              << Level.NumTriangles << " triangles";
+    if (!std::isnan(Level.MaxError)) {
+      std::cout << ", max error " << Level.MaxError;
+    }
+    std::cout << std::endl;
+  }
+  asyncTexture SphereTexture(GL_TEXTURE_2D, std::move(SphereFiles),
+                             {200, 200, 200, 255}, true /* mipmaps */);
 
   // Create and bind sphere Vertex Array Object (VA0)
   GLuint SphereVAO;
   glGenVertexArrays(1, &SphereVAO);
   glBindVertexArray(SphereVAO);
 
-  // Create and bind sphere Vertex Buffer Object (VBO)
-  GLuint SphereVertexVBO;
-  glGenBuffers(1, &SphereVertexVBO);
-  glBindBuffer(GL_ARRAY_BUFFER, SphereVertexVBO);
+  // Create and bind sphere Vertex Buffer Object (VBO), when packed this
+  // holds all the interleaved vertex attributes. Every level of detail
+  // shares the same buffers, and procedural spheres have none.
+  GLuint SphereVertexVBO = 0;
+  GLuint SphereNormalVBO = 0;
+  GLuint SphereTexCoordsVBO = 0;
+  size_t SphereVertexBytes = 0;
+  if (SphereFormat == vertexFormat::Packed) {
+    glGenBuffers(1, &SphereVertexVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, SphereVertexVBO);
+    const std::vector<packedVertex> &Packed = Sphere.getPackedVertices();
+    SphereVertexBytes = sizeof(packedVertex) * Packed.size();
+    glBufferData(GL_ARRAY_BUFFER, SphereVertexBytes, Packed.data(),
+                 GL_STATIC_DRAW);
+  } else if (SphereFormat == vertexFormat::Float) {
+    // Tie sphere vertex data to VBO
+    const std::vector<GLfloat> &Vertices = Sphere.getVertices();
+    glGenBuffers(1, &SphereVertexVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, SphereVertexVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * Vertices.size(),
+                 Vertices.data(), GL_STATIC_DRAW);
 
-  // Tie sphere vertex data to VBO
-  glBufferData(GL_ARRAY_BUFFER, Sphere.getVertexSize(), Sphere.getVertexData(),
-               GL_STATIC_DRAW);
+    const std::vector<GLfloat> &Normals = Sphere.getNormals();
+    glGenBuffers(1, &SphereNormalVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, SphereNormalVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * Normals.size(),
+                 Normals.data(), GL_STATIC_DRAW);
+
+    const std::vector<GLfloat> &TexCoords = Sphere.getTexCoords();
+    glGenBuffers(1, &SphereTexCoordsVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, SphereTexCoordsVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * TexCoords.size(),
+                 TexCoords.data(), GL_STATIC_DRAW);
+
+    SphereVertexBytes =
+        sizeof(GLfloat) * (Vertices.size() + Normals.size() + TexCoords.size());
+  }
 
   // Create and bind Element Buffer Object (EBO)
-  GLuint SphereEBO;
-  glGenBuffers(1, &SphereEBO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SphereEBO);
+  GLuint SphereEBO = 0;
+  const indexBuffer &SphereIndices = Sphere.getIndexBuffer();
+  if (!Procedural) {
+    glGenBuffers(1, &SphereEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SphereEBO);
 
-  // Tie index data to EBO
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, Sphere.getIndexSize(),
-               Sphere.getIndexData(), GL_STATIC_DRAW);
+    // Tie index data to EBO, reordered for the vertex cache and narrowed to
+    // 16-bit where possible
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, SphereIndices.getSize(),
+                 SphereIndices.getData(), GL_STATIC_DRAW);
+    if (SphereIndices.usesPrimitiveRestart()) {
+      // Restart index is the maximum value of the index type
+      glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    }
+  }
+  const size_t SphereIndexBytes = SphereIndices.getSize();
 
-  GLuint SphereNormalVBO;
-  glGenBuffers(1, &SphereNormalVBO);
-  glBindBuffer(GL_ARRAY_BUFFER, SphereNormalVBO);
-  glBufferData(GL_ARRAY_BUFFER, Sphere.getNormalSize(), Sphere.getNormalData(),
-               GL_STATIC_DRAW);
+  // Record the vertex layout in the VAO, procedural spheres have none
+  if (SphereFormat == vertexFormat::Packed) {
+    // Interleaved vertex, normal is derived from position in the shader
+    glBindBuffer(GL_ARRAY_BUFFER, SphereVertexVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0,                    // Matches shader layer
+                          3,                    // matches vec3
+                          GL_SHORT,             // type
+                          GL_TRUE,              // normalized?
+                          sizeof(packedVertex), // stride
+                          (void *)offsetof(packedVertex, Position));
 
-  GLuint SphereTexCoordsVBO;
-  glGenBuffers(1, &SphereTexCoordsVBO);
-  glBindBuffer(GL_ARRAY_BUFFER, SphereTexCoordsVBO);
-  glBufferData(GL_ARRAY_BUFFER, Sphere.getTexCoordSize(),
-               Sphere.getTexCoordData(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2,                    // attribute
+                          2,                    // size
+                          GL_UNSIGNED_SHORT,    // type
+                          GL_TRUE,              // normalized?
+                          sizeof(packedVertex), // stride
+                          (void *)offsetof(packedVertex, TexCoord));
+  } else if (SphereFormat == vertexFormat::Float) {
+    // Vertex
+    glBindBuffer(GL_ARRAY_BUFFER, SphereVertexVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0,        // Matches shader layer
+                          3,        // matches vec3
+                          GL_FLOAT, // type
+                          GL_FALSE, // normalized?
+                          0,        // stride, 0 lets GL decide
+                          (void *)0 // array buffer offset
+    );
+
+    // Normal
+    glBindBuffer(GL_ARRAY_BUFFER, SphereNormalVBO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1,        // attribute
+                          3,        // size
+                          GL_FLOAT, // type
+                          GL_FALSE, // normalized?
+                          0,        // stride
+                          (void *)0 // array buffer offset
+    );
+
+    // Texture Coordinate
+    glBindBuffer(GL_ARRAY_BUFFER, SphereTexCoordsVBO);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2,        // attribute
+                          2,        // size
+                          GL_FLOAT, // type
+                          GL_FALSE, // normalized?
+                          0,        // stride
+                          (void *)0 // array buffer offset
+    );
+  }
+
+  // GPU owns the vertex and index data now
+  Sphere.freeData();
+
+  // Per instance offset, scale and tint of every ball, drawn in one call.
+  // When culling, the visible balls are instead written each frame to a
+  // ring buffer, fenced so the GPU can still read the previous frames'.
+  const bool Culling = SphereMesh && Opts.Balls > 1 && Opts.Cull;
+  const size_t BallBytes = sizeof(ballInstance) * Opts.Balls;
+  std::vector<ballInstance> Balls = buildBalls(Opts.Balls);
+  GLuint BallVBO = 0;
+  if (!Culling) {
+    glGenBuffers(1, &BallVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, BallVBO);
+    glBufferData(GL_ARRAY_BUFFER, BallBytes, Balls.data(), GL_STATIC_DRAW);
+  }
+  streamBuffer BallStream(GL_ARRAY_BUFFER, Culling ? BallBytes : 1,
+                          Opts.PersistentMap);
+  ballCuller Culler(Culling ? std::move(Balls) : std::vector<ballInstance>(),
+                    Sphere.getRadius());
+  workerPool CullPool(Culling ? Opts.CullThreads : 1);
+  // Balls in view are written here when occlusion culling picks from them
+  const bool Occlusion = Culling && Opts.Occlusion;
+  std::vector<ballInstance> InViewBalls(Occlusion ? Opts.Balls : 0);
+  // Depth buffer a quarter of the window width
+  occlusionCuller Occluder(Occlusion ? WindowWidth / 4 : 0,
+                           Occlusion ? WindowHeight / 4 : 0);
+  Balls.clear();
+  Balls.shrink_to_fit();
+  // Ball offset and scale, then tint, are read from their own binding point
+  // advancing once per instance rather than per vertex. Only the buffer bound
+  // to it changes, when culling moves to the next streamed region.
+  const GLuint BallBinding = 3;
+  if (SphereMesh) {
+    glEnableVertexAttribArray(3);
+    glVertexAttribFormat(3, 4, GL_FLOAT, GL_FALSE,
+                         offsetof(ballInstance, OffsetScale));
+    glVertexAttribBinding(3, BallBinding);
+    glEnableVertexAttribArray(4);
+    glVertexAttribFormat(4, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                         offsetof(ballInstance, Tint));
+    glVertexAttribBinding(4, BallBinding);
+    glVertexBindingDivisor(BallBinding, 1);
+    glBindVertexBuffer(BallBinding, BallVBO, 0, sizeof(ballInstance));
+  }
+
+  // First use of each program, which waits for any still compiling
+  GLuint TextProgram;
+  try {
+    TextProgram = TextShaders.get();
+  } catch (std::exception &E) {
+    std::cerr << "Error " << E.what() << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  glm::mat4 TextProjMatrix = glm::ortho(0.0f, static_cast<float>(WindowWidth),
+                                        0.0f, static_cast<float>(WindowHeight));
+  GLuint TextMVPUniform = glGetUniformLocation(TextProgram, "MVP");
+  GLuint TextColorUniform = glGetUniformLocation(TextProgram, "TextColor");
+  glUseProgram(TextProgram);
+  glUniformMatrix4fv(TextMVPUniform, 1, GL_FALSE,
+                     glm::value_ptr(TextProjMatrix));
+  glm::vec3 TextColor(1., 1.f, 1.f);
+  glUniform3f(TextColorUniform, TextColor.x, TextColor.y, TextColor.z);
+
+  GLuint SkyboxProgram;
+  try {
+    SkyboxProgram = SkyboxShaders.get();
+  } catch (std::exception &E) {
+    std::cerr << "Error " << E.what() << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  GLuint SkyboxMVPUniform = glGetUniformLocation(SkyboxProgram, "MVP");
 
   GLuint SphereProgram;
   try {
-    SphereProgram = loadSphereShaders();
+    SphereProgram = SphereShaders.get();
   } catch (std::exception &E) {
     std::cerr << "Error " << E.what() << std::endl;
     glfwTerminate();
@@ -362,148 +898,667 @@ int main(int argc, char *argv[]) {
       glGetUniformLocation(SphereProgram, "LightPosition");
   GLuint SphereTexUniform = glGetUniformLocation(SphereProgram, "TexSampler");
 
+  // Packed and procedural positions are unit directions which double as the
+  // normal
+  const bool UnitPositions = SphereFormat != vertexFormat::Float;
+  glUseProgram(SphereProgram);
+  glUniform1f(glGetUniformLocation(SphereProgram, "PositionScale"),
+              UnitPositions ? Sphere.getRadius() : 1.0f);
+  glUniform1i(glGetUniformLocation(SphereProgram, "DeriveNormal"),
+              UnitPositions);
+  glUniform2f(glGetUniformLocation(SphereProgram, "TexCoordScale"),
+              SphereFormat == vertexFormat::Packed ? PackedMaxU : 1.0f, 1.0f);
+  glUniform1i(glGetUniformLocation(SphereProgram, "Procedural"), Procedural);
+  GLuint SphereStacksUniform = glGetUniformLocation(SphereProgram, "Stacks");
+  GLuint SphereSectorsUniform = glGetUniformLocation(SphereProgram, "Sectors");
+
+  // Program 0 is only deleted, never used, when not drawing impostors
+  GLuint ImpostorProgram = 0;
+  GLuint ImpostorVUniform = 0;
+  GLuint ImpostorPUniform = 0;
+  GLuint ImpostorCenterUniform = 0;
+  GLuint ImpostorLightUniform = 0;
+  if (Opts.Impostor) {
+    try {
+      ImpostorProgram = ImpostorShaders.get();
+    } catch (std::exception &E) {
+      std::cerr << "Error " << E.what() << std::endl;
+      glfwTerminate();
+      return -1;
+    }
+    ImpostorVUniform = glGetUniformLocation(ImpostorProgram, "V");
+    ImpostorPUniform = glGetUniformLocation(ImpostorProgram, "P");
+    ImpostorCenterUniform = glGetUniformLocation(ImpostorProgram, "Center");
+    ImpostorLightUniform =
+        glGetUniformLocation(ImpostorProgram, "LightPosition");
+
+    glUseProgram(ImpostorProgram);
+    glUniform1f(glGetUniformLocation(ImpostorProgram, "Radius"),
+                Sphere.getRadius());
+  }
+
+  // Tessellation objects, left as 0 unless --tessellation is used
+  GLuint TessVAO = 0;
+  GLuint TessProgram = 0;
+  GLuint TessVertexVBO = 0;
+  GLuint TessTexCoordsVBO = 0;
+  GLuint TessEBO = 0;
+  GLsizei TessNumIndices = 0;
+  GLuint TessMVPUniform = 0;
+  GLuint TessVUniform = 0;
+  GLuint TessLightUniform = 0;
+  GLuint TessCameraUniform = 0;
+  GLuint TessPixelsUniform = 0;
+  if (Opts.Tessellation) {
+    // Each triangle of the icosahedron is a patch, its unit vertex positions
+    // double as normals
+    sphere Base = sphere::icosahedron(1.0f);
+    glGenVertexArrays(1, &TessVAO);
+    glBindVertexArray(TessVAO);
+    glGenBuffers(1, &TessVertexVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, TessVertexVBO);
+    glBufferData(GL_ARRAY_BUFFER, Base.getNormalSize(), Base.getNormalData(),
+                 GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    glGenBuffers(1, &TessTexCoordsVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, TessTexCoordsVBO);
+    glBufferData(GL_ARRAY_BUFFER, Base.getTexCoordSize(),
+                 Base.getTexCoordData(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void *)0);
+    glGenBuffers(1, &TessEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, TessEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, Base.getIndexSize(),
+                 Base.getIndexData(), GL_STATIC_DRAW);
+    TessNumIndices = Base.getIndices().size();
+    SphereVertexBytes = Base.getNormalSize() + Base.getTexCoordSize();
+
+    try {
+      TessProgram = TessShaders.get();
+    } catch (std::exception &E) {
+      std::cerr << "Error " << E.what() << std::endl;
+      glfwTerminate();
+      return -1;
+    }
+    TessMVPUniform = glGetUniformLocation(TessProgram, "MVP");
+    TessVUniform = glGetUniformLocation(TessProgram, "V");
+    TessLightUniform = glGetUniformLocation(TessProgram, "LightPosition");
+    TessCameraUniform = glGetUniformLocation(TessProgram, "CameraPosition");
+    TessPixelsUniform = glGetUniformLocation(TessProgram, "PixelsPerUnit");
+
+    // Same edge length target as level of detail selection
+    glUseProgram(TessProgram);
+    glUniform1f(glGetUniformLocation(TessProgram, "Radius"),
+                Sphere.getRadius());
+    glUniform1f(glGetUniformLocation(TessProgram, "TargetEdgePixels"), 4.0f);
+    glPatchParameteri(GL_PATCH_VERTICES, 3);
+  }
+
   // Matches sun on skybox texture
   glm::vec3 SphereLightPos = glm::vec3(4, 4, 4);
 
-  controls Controls(Window, WindowWidth, WindowHeight);
+  // Camera is fixed in headless mode as there is no user input
+  controls Controls(Opts.Headless ? nullptr : Window, WindowWidth,
+                    WindowHeight);
+  frameTimers Timers;
+  // Overlay lines, each only laid out and uploaded again when it changes.
+  // Timing summaries are refreshed along with the FPS.
+  const textLabel FPSLabel = Text.createLabel(5.0f, 5.0f, .5f);
+  const textLabel PositionLabel = Text.createLabel(5.0f, 40.0f, .5f);
+  textLabel TimerLabels[static_cast<unsigned>(pass::Count) + 1];
+  float LineY = 75.0f;
+  for (textLabel &Label : TimerLabels) {
+    Label = Text.createLabel(5.0f, LineY, .4f);
+    LineY += 25.0f;
+  }
+  const textLabel LODLabel = Text.createLabel(5.0f, LineY, .4f);
+  // Culling lines stay empty, and take no space, when disabled
+  const textLabel CullLabel = Text.createLabel(5.0f, LineY += 25.0f, .4f);
+  const textLabel OcclusionLabel =
+      Text.createLabel(5.0f, LineY += Culling ? 25.0f : 0.0f, .4f);
+  const textLabel TextStatsLabel =
+      Text.createLabel(5.0f, LineY += Occlusion ? 25.0f : 0.0f, .4f);
+  const textLabel StateLabel = Text.createLabel(5.0f, LineY += 25.0f, .4f);
+  const textLabel GLCallsLabel = Text.createLabel(5.0f, LineY += 25.0f, .4f);
+  Text.setLabel(FPSLabel, "FPS: ");
+  // Sphere level of detail displayed in the overlay, rebuilt on change
+  unsigned SphereLevel = 0;
+  int SphereDetailSteps = 0;
+  std::string StrLOD;
+  // CPU time spent issuing the sphere mesh pass
+  std::chrono::duration<double> SphereSubmitTime(0);
+  // Balls drawn by, and in view but hidden from, the last frame, and totals
+  // over every frame for culling
+  size_t NumVisibleBalls = Opts.Balls;
+  size_t NumHiddenBalls = 0;
+  size_t TotalVisibleBalls = 0;
+  size_t TotalHiddenBalls = 0;
+  // CPU time of all culling, and of occlusion culling alone
+  std::chrono::duration<double> CullTime(0);
+  std::chrono::duration<double> OcclusionTime(0);
+  // Text submitted over every frame
+  size_t TotalGlyphs = 0;
+  size_t TotalTextDrawCalls = 0;
+  size_t TotalTextBytes = 0;
+  size_t TotalRelaid = 0;
+  size_t TotalRasterized = 0;
+  // GL binds issued and skipped as redundant by the last frame, and in total
+  glStateStats LastStateStats{};
+  size_t TotalStateBinds = 0;
+  size_t TotalStateSkipped = 0;
+  if (Opts.Impostor) {
+    StrLOD = "Ray-cast impostor, 2 triangles";
+  } else if (Opts.Tessellation) {
+    StrLOD = "Tessellated icosahedron, " + std::to_string(TessNumIndices / 3) +
+             " patches";
+  }
+  Text.setLabel(LODLabel, StrLOD);
+
   double Timestamp = glfwGetTime(); // seconds
   unsigned ElapsedFrames = 0;
   unsigned FPS = 0;
+  unsigned TotalFrames = 0;
+  auto LoopStart = std::chrono::steady_clock::now();
+  // Nothing is looked up when the driver can't cache programs
+  if (const shaderCacheStats &ShaderStats = getShaderCacheStats();
+      ShaderStats.Hits + ShaderStats.Misses > 0) {
+    std::cout << "Shader cache: " << ShaderStats.Hits << " hits, "
+              << ShaderStats.Misses << " misses (" << ShaderStats.Rejected
+              << " rejected), saved " << ShaderStats.SavedMs << " ms"
+              << std::endl;
+  }
+  const shaderCompileStats &CompileStats = getShaderCompileStats();
+  std::cout << "Shader compile: " << CompileStats.Programs << " programs, "
+            << (CompileStats.Parallel ? "parallel, " : "")
+            << CompileStats.NotReady << " not ready at first use, waited "
+            << CompileStats.WaitMs << " ms" << std::endl;
+
+  // Setup bound objects directly, every frame binds through the cache
+  glState &State = glState::get();
+  State.invalidate();
+  StartupZone.end();
+  bool AssetsLoaded = false;
   do {
+    // Textures are uploaded between frames as they finish decoding, or all
+    // before the first with --sync-assets
+    if (!AssetsLoaded) {
+      TRACE_ZONE("update textures");
+      const bool Wait = Opts.SyncAssets;
+      try {
+        // Both are updated, so one can upload while the other still decodes
+        AssetsLoaded = SkyboxTexture.update(Wait) & SphereTexture.update(Wait);
+      } catch (std::exception &E) {
+        std::cerr << "Error " << E.what() << std::endl;
+        glfwTerminate();
+        return -1;
+      }
+      if (AssetsLoaded) {
+        std::chrono::duration<double, std::milli> LoadTime =
+            std::chrono::steady_clock::now() - LaunchTime;
+        std::cout << "Fully loaded after " << LoadTime.count() << " ms, "
+                  << (SkyboxTexture.getBytes() + SphereTexture.getBytes()) /
+                         1024
+                  << " KiB of textures" << std::endl;
+      }
+    }
+
+    TRACE_ZONE("frame");
+    Timers.beginFrame();
+    if constexpr (glCounter::Enabled) {
+      glCounter::get().beginFrame();
+    }
+
     // Measure FPS
     ElapsedFrames++;
     if (double CurrentTime = glfwGetTime(); (CurrentTime - Timestamp) >= 1.0) {
       Timestamp = CurrentTime;
       FPS = ElapsedFrames;
       ElapsedFrames = 0;
+
+      Text.setLabel(FPSLabel, "FPS: " + std::to_string(FPS));
+      Text.setLabel(TimerLabels[0], Timers.getFrameSummaryStr());
+      for (unsigned P = 0; P < static_cast<unsigned>(pass::Count); P++) {
+        Text.setLabel(TimerLabels[P + 1],
+                      Timers.getSummaryStr(static_cast<pass>(P)));
+      }
+      const textStats &Stats = Text.getStats();
+      Text.setLabel(TextStatsLabel,
+                    "Text: " + std::to_string(Stats.Glyphs) + " glyphs, " +
+                        std::to_string(Stats.DrawCalls) + " draw calls, " +
+                        std::to_string(Stats.UploadBytes) + " bytes, " +
+                        std::to_string(Stats.Relaid) + " relaid, " +
+                        std::to_string(Stats.Rasterized) + " rasterized");
+      Text.setLabel(StateLabel,
+                    "GL state: " + std::to_string(LastStateStats.Binds) +
+                        " binds, " + std::to_string(LastStateStats.Skipped) +
+                        " skipped as redundant");
+      if constexpr (glCounter::Enabled) {
+        const glCallStats &Calls = glCounter::get().getFrameStats();
+        Text.setLabel(GLCallsLabel,
+                      "GL: " + std::to_string(Calls.CountedCalls) +
+                          " counted calls, " +
+                          std::to_string(Calls.DrawCalls) + " draws, " +
+                          std::to_string(Calls.Primitives) + " primitives, " +
+                          std::to_string(Calls.ProgramBinds +
+                                         Calls.VertexArrayBinds +
+                                         Calls.BufferBinds +
+                                         Calls.TextureBinds) +
+                          " binds, " + std::to_string(Calls.UniformUpdates) +
+                          " uniforms, " + std::to_string(Calls.UploadBytes) +
+                          " bytes");
+      }
+      if (Culling && TotalFrames) {
+        std::stringstream sstr;
+        sstr << std::fixed << std::setprecision(3) << "Visible "
+             << NumVisibleBalls << "/" << Opts.Balls << " balls, mean cull "
+             << (CullTime.count() * 1000.0) / TotalFrames << " ms on "
+             << CullPool.getNumThreads() << " threads";
+        Text.setLabel(CullLabel, sstr.str());
+      }
+      if (Occlusion && TotalFrames) {
+        std::stringstream sstr;
+        sstr << std::fixed << std::setprecision(3) << "Occlusion hid "
+             << NumHiddenBalls << " balls, mean "
+             << (OcclusionTime.count() * 1000.0) / TotalFrames << " ms";
+        Text.setLabel(OcclusionLabel, sstr.str());
+      }
     }
 
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Refresh user inputs
-    Controls.refreshMatrices();
+    {
+      TRACE_ZONE("refresh controls");
+      Controls.refreshMatrices();
+    }
 
     // Sphere
-    glm::mat4 SphereMVP = Controls.getMVPMatrix(Sphere.getModelMatrix(), false);
-    glm::mat4 SphereView = Controls.getViewMatrix();
-    glUseProgram(SphereProgram);
-    glUniformMatrix4fv(SphereMVPUniform, 1, GL_FALSE, &SphereMVP[0][0]);
-    glUniformMatrix4fv(SphereVUniform, 1, GL_FALSE, &SphereView[0][0]);
-    glUniform3f(SphereLightUniform, SphereLightPos.x, SphereLightPos.y,
-                SphereLightPos.z);
+    if (Opts.Impostor) {
+      TRACE_ZONE("sphere impostor pass");
+      Timers.beginPass(pass::Sphere);
+      glm::mat4 SphereView = Controls.getViewMatrix();
+      glm::mat4 SphereProj = Controls.getProjectionMatrix();
+      glm::vec3 SphereCenter(0.f);
 
-    // Vertex
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, SphereVertexVBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SphereEBO);
-    glVertexAttribPointer(0,        // Matches shader layer
-                          3,        // matches vec3
-                          GL_FLOAT, // type
-                          GL_FALSE, // normalized?
-                          0,        // stride, 0 lets GL decide
-                          (void *)0 // array buffer offset
-    );
+      // No quad can cover the view from inside the sphere
+      if (glm::distance(Controls.getPosition(), SphereCenter) >
+          Sphere.getRadius()) {
+        State.useProgram(ImpostorProgram);
+        // No vertex attributes, so any vertex array will do
+        State.bindVertexArray(SphereVAO);
+        glUniformMatrix4fv(ImpostorVUniform, 1, GL_FALSE, &SphereView[0][0]);
+        glUniformMatrix4fv(ImpostorPUniform, 1, GL_FALSE, &SphereProj[0][0]);
+        glUniform3f(ImpostorCenterUniform, SphereCenter.x, SphereCenter.y,
+                    SphereCenter.z);
+        glUniform3f(ImpostorLightUniform, SphereLightPos.x, SphereLightPos.y,
+                    SphereLightPos.z);
 
-    // Normal
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, SphereNormalVBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SphereEBO);
-    glVertexAttribPointer(1,        // attribute
-                          3,        // size
-                          GL_FLOAT, // type
-                          GL_FALSE, // normalized?
-                          0,        // stride
-                          (void *)0 // array buffer offset
-    );
+        State.bindTexture(0, GL_TEXTURE_2D, SphereTexture.get());
 
-    // Texture Coordinate
-    glEnableVertexAttribArray(2);
-    glBindBuffer(GL_ARRAY_BUFFER, SphereTexCoordsVBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SphereEBO);
-    glVertexAttribPointer(2,        // attribute
-                          2,        // size
-                          GL_FLOAT, // type
-                          GL_FALSE, // normalized?
-                          0,        // stride
-                          (void *)0 // array buffer offset
-    );
+        // Quad corners come from gl_VertexID
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+      }
+      Timers.endPass(pass::Sphere);
+    } else if (Opts.Tessellation) {
+      TRACE_ZONE("sphere tessellation pass");
+      Timers.beginPass(pass::Sphere);
+      glm::mat4 SphereMVP =
+          Controls.getMVPMatrix(Sphere.getModelMatrix(), false);
+      glm::mat4 SphereView = Controls.getViewMatrix();
+      glm::vec3 CameraPos = Controls.getPosition();
+      // Scales world units at distance 1 to pixels, as in getProjectedRadius
+      float PixelsPerUnit =
+          Controls.getProjectionMatrix()[1][1] * (WindowHeight * 0.5f);
+
+      State.useProgram(TessProgram);
+      State.bindVertexArray(TessVAO);
+      glUniformMatrix4fv(TessMVPUniform, 1, GL_FALSE, &SphereMVP[0][0]);
+      glUniformMatrix4fv(TessVUniform, 1, GL_FALSE, &SphereView[0][0]);
+      glUniform3f(TessLightUniform, SphereLightPos.x, SphereLightPos.y,
+                  SphereLightPos.z);
+      glUniform3f(TessCameraUniform, CameraPos.x, CameraPos.y, CameraPos.z);
+      glUniform1f(TessPixelsUniform, PixelsPerUnit);
+
+      State.bindTexture(0, GL_TEXTURE_2D, SphereTexture.get());
+
+      glDrawElements(GL_PATCHES, TessNumIndices, GL_UNSIGNED_INT, (void *)0);
+      Timers.endPass(pass::Sphere);
+    } else {
+      TRACE_ZONE("sphere pass");
+      Timers.beginPass(pass::Sphere);
+      glm::mat4 SphereMVP =
+          Controls.getMVPMatrix(Sphere.getModelMatrix(), false);
+      glm::mat4 SphereView = Controls.getViewMatrix();
+
+      // Pick the level of detail from the size of the sphere on screen, or of
+      // the ball at the centre of the grid
+      float PixelRadius = getProjectedRadius(
+          glm::vec3(0.f), Sphere.getRadius() * getBallScale(Opts.Balls),
+          Controls.getPosition(), Controls.getProjectionMatrix(),
+          WindowHeight);
+      unsigned NewLevel = Sphere.selectLevel(PixelRadius);
+      const lodLevel &Level = Sphere.getLevel(NewLevel);
+
+      // Procedural tessellation is a uniform, so the detail keys can change
+      // it without uploading anything. Detail is lowered until the vertex
+      // count of the draw fits a GLsizei.
+      int DetailSteps = Procedural ? Controls.getDetailSteps() : 0;
+      auto ScaleDetail = [&DetailSteps](unsigned N) -> uint64_t {
+        return DetailSteps >= 0
+                   ? uint64_t(N) << DetailSteps
+                   : std::max<uint64_t>(2, N >> std::min(-DetailSteps, 31));
+      };
+      constexpr double MaxVertices = std::numeric_limits<GLsizei>::max();
+      while (Procedural && 6.0 * ScaleDetail(Level.Sectors) *
+                                   (ScaleDetail(Level.Stacks) - 1) >
+                               MaxVertices) {
+        DetailSteps--;
+      }
+      const unsigned Stacks = ScaleDetail(Level.Stacks);
+      const unsigned Sectors = ScaleDetail(Level.Sectors);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, SphereTexture);
+      if (NewLevel != SphereLevel || DetailSteps != SphereDetailSteps ||
+          StrLOD.empty()) {
+        SphereLevel = NewLevel;
+        SphereDetailSteps = DetailSteps;
+        StrLOD = "LOD " + std::to_string(SphereLevel) + "/" +
+                 std::to_string(Sphere.getNumLevels()) + ": ";
+        if (Procedural) {
+          StrLOD += "procedural uv " + std::to_string(Stacks) + "x" +
+                    std::to_string(Sectors) + ", " +
+                    std::to_string(getUVTriangles(Sectors, Stacks));
+        } else {
+          StrLOD += Level.Description + ", " +
+                    std::to_string(Level.NumTriangles);
+        }
+        StrLOD += " triangles";
+        if (Opts.Balls > 1) {
+          StrLOD += " x " + std::to_string(Opts.Balls) + " balls";
+        }
+        Text.setLabel(LODLabel, StrLOD);
+      }
+
+      GLintptr BallOffset = 0;
+      if (Culling) {
+        auto CullStart = std::chrono::steady_clock::now();
+        BallStream.beginFrame();
+        auto *Visible = static_cast<ballInstance *>(BallStream.map(BallBytes));
+        if (Occlusion) {
+          size_t NumInView =
+              Culler.cull(SphereMVP, CullPool, InViewBalls.data());
+          auto OcclusionStart = std::chrono::steady_clock::now();
+          NumVisibleBalls = Occluder.cull(
+              InViewBalls.data(), NumInView, Sphere.getRadius(), SphereView,
+              Controls.getProjectionMatrix(), CullPool, Visible);
+          NumHiddenBalls = NumInView - NumVisibleBalls;
+          OcclusionTime += std::chrono::steady_clock::now() - OcclusionStart;
+        } else {
+          NumVisibleBalls = Culler.cull(SphereMVP, CullPool, Visible);
+        }
+        BallOffset = BallStream.commit();
+        if (BallOffset < 0) {
+          NumVisibleBalls = 0;
+        }
+        TotalVisibleBalls += NumVisibleBalls;
+        TotalHiddenBalls += NumHiddenBalls;
+        CullTime += std::chrono::steady_clock::now() - CullStart;
+      }
 
-    glDrawElements(GL_TRIANGLES,          // primitive type
-                   Sphere.getIndexSize(), // # of indices
-                   GL_UNSIGNED_INT,       // data type
-                   (void *)0);            // ptr to indices
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(2);
+      auto SubmitStart = std::chrono::steady_clock::now();
+      State.useProgram(SphereProgram);
+      // Vertex and instance layouts were recorded at load time
+      State.bindVertexArray(SphereVAO);
+      if (Culling && BallOffset >= 0) {
+        glBindVertexBuffer(BallBinding, BallStream.getBuffer(), BallOffset,
+                           sizeof(ballInstance));
+      }
+      State.bindTexture(0, GL_TEXTURE_2D, SphereTexture.get());
+      glUniformMatrix4fv(SphereMVPUniform, 1, GL_FALSE, &SphereMVP[0][0]);
+      glUniformMatrix4fv(SphereVUniform, 1, GL_FALSE, &SphereView[0][0]);
+      glUniform3f(SphereLightUniform, SphereLightPos.x, SphereLightPos.y,
+                  SphereLightPos.z);
+
+      if (Procedural) {
+        // Positions come from gl_VertexID
+        glUniform1ui(SphereStacksUniform, Stacks);
+        glUniform1ui(SphereSectorsUniform, Sectors);
+        const uint64_t NumVertices = 3 * getUVTriangles(Sectors, Stacks);
+        glDrawArraysInstanced(GL_TRIANGLES, 0,
+                              static_cast<GLsizei>(NumVertices),
+                              NumVisibleBalls);
+      } else {
+        glDrawElementsInstancedBaseVertex(
+            SphereIndices.Mode,        // primitive type
+            Level.IndexCount,          // # of indices
+            SphereIndices.Type,        // data type
+            (void *)Level.IndexOffset, // ptr to indices
+            NumVisibleBalls,           // # of instances
+            Level.BaseVertex);         // first vertex
+      }
+      if (Culling) {
+        // Fenced after the draw reading this frame's balls
+        BallStream.endFrame();
+      }
+      SphereSubmitTime += std::chrono::steady_clock::now() - SubmitStart;
+      Timers.endPass(pass::Sphere);
+    }
 
     // Skybox
-    glm::mat4 SkyboxMVP = Controls.getMVPMatrix(Skybox.getModelMatrix(), true);
-    glUseProgram(SkyboxProgram);
-    glBindBuffer(GL_ARRAY_BUFFER, SkyboxVBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, SkyboxEBO);
-    glUniformMatrix4fv(SkyboxMVPUniform, 1, GL_FALSE, &SkyboxMVP[0][0]);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0,        // Matches shader layer
-                          3,        // matches vec3
-                          GL_FLOAT, // type
-                          GL_FALSE, // normalized?
-                          0,        // stride, 0 lets GL decide
-                          (void *)0 // array buffer offset
-    );
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, SkyboxTexture);
-    glDrawElements(GL_TRIANGLES,          // primitive type
-                   Skybox.getIndexSize(), // # of indices
-                   GL_UNSIGNED_INT,       // data type
-                   (void *)0);            // ptr to indices
-    glDisableVertexAttribArray(0);
+    {
+      TRACE_ZONE("skybox pass");
+      Timers.beginPass(pass::Skybox);
+      glm::mat4 SkyboxMVP =
+          Controls.getMVPMatrix(Skybox.getModelMatrix(), true);
+      State.useProgram(SkyboxProgram);
+      State.bindVertexArray(SkyboxVAO);
+      State.bindTexture(0, GL_TEXTURE_CUBE_MAP, SkyboxTexture.get());
+      glUniformMatrix4fv(SkyboxMVPUniform, 1, GL_FALSE, &SkyboxMVP[0][0]);
+      glDrawElements(GL_TRIANGLES,       // primitive type
+                     Skybox.MNumIndices, // # of indices
+                     GL_UNSIGNED_INT,    // data type
+                     (void *)0);         // ptr to indices
+      Timers.endPass(pass::Skybox);
+    }
 
     // Text
-    glUseProgram(TextProgram);
-    glEnableVertexAttribArray(0);
-    glm::vec3 TextColor(1., 1.f, 1.f);
-    glUniform3f(TextColorUniform, TextColor.x, TextColor.y, TextColor.z);
-    glBindBuffer(GL_ARRAY_BUFFER, TextVBO);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glActiveTexture(GL_TEXTURE0);
-
-    std::string StrFPS("FPS: ");
-    if (FPS) {
-      StrFPS.append(std::to_string(FPS));
+    {
+      TRACE_ZONE("text pass");
+      Timers.beginPass(pass::Text);
+      State.useProgram(TextProgram);
+      State.bindVertexArray(TextVAO);
+
+      // The position changes whenever the camera moves, format it without
+      // allocating. Unchanged labels aren't laid out or uploaded again.
+      char StrPosition[controls::PositionStrSize];
+      Text.setLabel(PositionLabel,
+                    std::string_view(StrPosition,
+                                     Controls.formatPosition(
+                                         StrPosition, sizeof(StrPosition))));
+      // Every label in one draw call
+      Text.draw(TextVBO);
+      TotalGlyphs += Text.getStats().Glyphs;
+      TotalTextDrawCalls += Text.getStats().DrawCalls;
+      TotalTextBytes += Text.getStats().UploadBytes;
+      TotalRelaid += Text.getStats().Relaid;
+      TotalRasterized += Text.getStats().Rasterized;
+      Timers.endPass(pass::Text);
     }
-    Text.render(TextVBO, StrFPS, 5.0f, 5.0f, .5f);
-    Text.render(TextVBO, Controls.getPositionStr(), 5.0f, 40.0f, .5f);
+    Timers.endFrame();
+    if constexpr (glCounter::Enabled) {
+      glCounter::get().endFrame();
+    }
+    LastStateStats = State.getStats();
+    TotalStateBinds += LastStateStats.Binds;
+    TotalStateSkipped += LastStateStats.Skipped;
+    State.resetStats();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisableVertexAttribArray(0);
+    TotalFrames++;
+    if (!Opts.Headless) {
+      TRACE_ZONE("swap buffers");
+      // Swap buffers
+      glfwSwapBuffers(Window);
+      glfwPollEvents();
+    }
+    if (TotalFrames == 1) {
+      std::chrono::duration<double, std::milli> FirstFrameTime =
+          std::chrono::steady_clock::now() - LaunchTime;
+      std::cout << "First frame after " << FirstFrameTime.count() << " ms"
+                << std::endl;
+    }
+  } // Check if the frame limit was reached, or the ESC key was pressed or the
+    // window was closed
+  while ((Opts.Frames == 0 || TotalFrames < Opts.Frames) &&
+         (Opts.Headless ||
+          (glfwGetKey(Window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+           glfwWindowShouldClose(Window) == 0)));
+  if (!AssetsLoaded) {
+    std::cout << "Exited before every texture was loaded" << std::endl;
+  }
 
-    // Swap buffers
-    glfwSwapBuffers(Window);
-    glfwPollEvents();
-  } // Check if the ESC key was pressed or the window was closed
-  while (glfwGetKey(Window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
-         glfwWindowShouldClose(Window) == 0);
+  if (Opts.Frames != 0) {
+    // Wait for queued GL work so the wall time covers all rendered frames
+    glFinish();
+    std::chrono::duration<double> WallTime =
+        std::chrono::steady_clock::now() - LoopStart;
+    double Seconds = WallTime.count();
+    if (Opts.Impostor) {
+      std::cout << "Sphere vertex and index buffers: 0 bytes, ray-cast "
+                << "impostor" << std::endl;
+    } else if (Opts.Tessellation) {
+      std::cout << "Sphere vertex and index buffers: "
+                << SphereVertexBytes + TessNumIndices * sizeof(GLuint)
+                << " bytes, tessellated icosahedron" << std::endl;
+    } else if (Procedural) {
+      std::cout << "Sphere vertex and index buffers: 0 bytes, generated from "
+                << "gl_VertexID" << std::endl;
+    } else {
+      std::cout << "Sphere vertex buffers: " << SphereVertexBytes
+                << " bytes (" << SphereVertexBytes / Sphere.getNumVertices()
+                << " bytes/vertex)" << std::endl
+                << "Sphere index buffer: " << SphereIndexBytes << " bytes, "
+                << (SphereIndices.Type == GL_UNSIGNED_SHORT ? 16 : 32)
+                << "-bit, ACMR " << SphereIndices.ACMRBefore << " -> "
+                << SphereIndices.ACMRAfter << std::endl;
+    }
+    if (SphereMesh) {
+      std::cout << "Balls: " << Opts.Balls << ", mean sphere submission "
+                << (SphereSubmitTime.count() * 1.0e6) / TotalFrames
+                << " us (CPU)" << std::endl;
+    }
+    if (Culling) {
+      std::cout << "Culling: mean " << TotalVisibleBalls / TotalFrames << "/"
+                << Opts.Balls << " balls visible, mean "
+                << (CullTime.count() * 1.0e6) / TotalFrames << " us on "
+                << CullPool.getNumThreads() << " threads (CPU)" << std::endl;
+      const streamStats &Stream = BallStream.getStats();
+      std::cout << "Ball streaming: "
+                << (BallStream.isPersistent() ? "persistent" : "unsynchronized")
+                << " map, " << Stream.Bytes / TotalFrames
+                << " bytes per frame, waited on " << Stream.Waits
+                << " frames for " << Stream.WaitTime.count() * 1000.0
+                << " ms total" << std::endl;
+    }
+    if (Occlusion) {
+      std::cout << "Occlusion: mean " << TotalHiddenBalls / TotalFrames
+                << " balls hidden, mean "
+                << (OcclusionTime.count() * 1.0e6) / TotalFrames
+                << " us (CPU)" << std::endl;
+    }
+    std::cout << "Text: mean " << TotalGlyphs / TotalFrames << " glyphs in "
+              << double(TotalTextDrawCalls) / TotalFrames
+              << " draw calls, " << TotalTextBytes / TotalFrames
+              << " bytes uploaded per frame, "
+              << double(TotalRelaid) / TotalFrames << " labels laid out per "
+              << "frame, " << TotalRasterized << " glyphs rasterized"
+              << std::endl;
+    std::cout << "GL state: mean " << double(TotalStateBinds) / TotalFrames
+              << " binds per frame, "
+              << double(TotalStateSkipped) / TotalFrames
+              << " skipped as redundant" << std::endl;
+    std::cout << "GPU timers: waited on results in " << Timers.getNumStalls()
+              << " frames, " << Timers.getNumPending()
+              << " samples dropped on exit" << std::endl;
+    if constexpr (glCounter::Enabled) {
+      const glCallStats &Calls = glCounter::get().getTotalStats();
+      const double Frames = glCounter::get().getNumFrames();
+      std::cout << "GL calls: mean " << Calls.CountedCalls / Frames
+                << " counted calls, "
+                << Calls.DrawCalls / Frames << " draws, "
+                << Calls.Primitives / Frames << " primitives, "
+                << Calls.ProgramBinds / Frames << " program, "
+                << Calls.VertexArrayBinds / Frames << " vertex array, "
+                << Calls.BufferBinds / Frames << " buffer and "
+                << Calls.TextureBinds / Frames << " texture binds, "
+                << Calls.UniformUpdates / Frames << " uniforms and "
+                << Calls.UploadBytes / Frames << " bytes uploaded per frame"
+                << std::endl;
+    }
+    std::cout << "Frames: " << TotalFrames << std::endl
+              << "Total wall time: " << Seconds << " s" << std::endl
+              << "Mean frame time: " << (Seconds * 1000.0) / TotalFrames
+              << " ms" << std::endl
+              << "Frames per second: " << TotalFrames / Seconds << std::endl;
+  }
+
+  if (!Opts.StatsPath.empty()) {
+    try {
+      Timers.writeJSON(Opts.StatsPath);
+    } catch (std::exception &E) {
+      std::cerr << "Error " << E.what() << std::endl;
+    }
+  }
+
+  if (!Opts.TracePath.empty()) {
+    try {
+      tracer::get().writeJSON(Opts.TracePath);
+    } catch (std::exception &E) {
+      std::cerr << "Error " << E.what() << std::endl;
+    }
+  }
+
+  if constexpr (glCounter::Enabled) {
+    if (!Opts.GLCallsPath.empty()) {
+      try {
+        glCounter::get().writeCSV(Opts.GLCallsPath);
+      } catch (std::exception &E) {
+        std::cerr << "Error " << E.what() << std::endl;
+      }
+    }
+  }
 
   // Cleanup
   glDeleteProgram(SphereProgram);
+  glDeleteProgram(ImpostorProgram);
+  glDeleteProgram(TessProgram);
+  glDeleteVertexArrays(1, &TessVAO);
+  glDeleteBuffers(1, &TessVertexVBO);
+  glDeleteBuffers(1, &TessTexCoordsVBO);
+  glDeleteBuffers(1, &TessEBO);
   glDeleteProgram(SkyboxProgram);
   glDeleteVertexArrays(1, &SphereVAO);
+  // Buffers which weren't created are 0, which GL silently ignores
   glDeleteBuffers(1, &SphereVertexVBO);
   glDeleteBuffers(1, &SphereNormalVBO);
   glDeleteBuffers(1, &SphereTexCoordsVBO);
   glDeleteBuffers(1, &SphereEBO);
-  glDeleteTextures(1, &SphereTexture);
+  glDeleteBuffers(1, &BallVBO);
+  BallStream.freeBuffer();
+  SphereTexture.freeTexture();
   glDeleteVertexArrays(1, &SkyboxVAO);
   glDeleteBuffers(1, &SkyboxVBO);
   glDeleteBuffers(1, &SkyboxEBO);
-  glDeleteTextures(1, &SkyboxTexture);
+  SkyboxTexture.freeTexture();
   glDeleteVertexArrays(1, &TextVAO);
   glDeleteBuffers(1, &TextVBO);
   Text.freeTextures();
+  Timers.freeQueries();
+  if (Opts.Headless) {
+    glDeleteRenderbuffers(1, &OffscreenColorRBO);
+    glDeleteRenderbuffers(1, &OffscreenDepthRBO);
+    glDeleteFramebuffers(1, &OffscreenFBO);
+  }
   // Close OpenGL window and terminate GLFW
   glfwTerminate();
 
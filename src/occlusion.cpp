@@ -0,0 +1,357 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "occlusion.h"
+#include "trace.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr unsigned TilePixels =
+    occlusionCuller::TileWidth * occlusionCuller::TileHeight;
+// Balls tested by one task
+constexpr size_t ChunkSize = 4096;
+// Work split across the pool, smaller jobs run on the calling thread
+constexpr size_t MinChunksPerThread = 4;
+// Rows of tiles rasterized by one task
+constexpr size_t MinTileRowsPerThread = 4;
+// Marks an empty occluder candidate slot
+constexpr unsigned NoCandidate = UINT_MAX;
+
+glm::vec3 getViewCentre(const ballInstance &Ball, const glm::mat4 &View) {
+  glm::vec4 Centre = View * glm::vec4(Ball.OffsetScale[0], Ball.OffsetScale[1],
+                                      Ball.OffsetScale[2], 1.0f);
+  return glm::vec3(Centre);
+}
+
+#if defined(__SSE2__)
+// Lanes of a tile row [X, X + 4) which lie in [X0, X1)
+__m128 getColumnMask(int X, int X0, int X1) {
+  const __m128i Columns = _mm_add_epi32(_mm_set1_epi32(X),
+                                        _mm_setr_epi32(0, 1, 2, 3));
+  const __m128i After = _mm_cmpgt_epi32(Columns, _mm_set1_epi32(X0 - 1));
+  const __m128i Before = _mm_cmplt_epi32(Columns, _mm_set1_epi32(X1));
+  return _mm_castsi128_ps(_mm_and_si128(After, Before));
+}
+#endif
+} // namespace
+
+occlusionCuller::occlusionCuller(unsigned Width, unsigned Height,
+                                 unsigned NumOccluders)
+    : MTilesX((Width + TileWidth - 1) / TileWidth),
+      MTilesY((Height + TileHeight - 1) / TileHeight),
+      MNumOccluders(NumOccluders), MScaleX(0.0f), MScaleY(0.0f),
+      MNear(0.0f) {
+  MDepth.resize(size_t(MTilesX) * MTilesY * TilePixels);
+  MTileMax.resize(size_t(MTilesX) * MTilesY);
+  clear();
+}
+
+void occlusionCuller::setProjection(const glm::mat4 &Proj) {
+  MScaleX = 0.5f * getWidth() * Proj[0][0];
+  MScaleY = 0.5f * getHeight() * Proj[1][1];
+  // Inverse of the depth terms of glm::perspective()
+  MNear = Proj[3][2] / (Proj[2][2] - 1.0f);
+}
+
+void occlusionCuller::clear() {
+  std::fill(MDepth.begin(), MDepth.end(), FLT_MAX);
+  std::fill(MTileMax.begin(), MTileMax.end(), FLT_MAX);
+}
+
+float occlusionCuller::getDepth(unsigned X, unsigned Y) const {
+  const size_t Tile = size_t(Y / TileHeight) * MTilesX + X / TileWidth;
+  return MDepth[Tile * TilePixels + (Y % TileHeight) * TileWidth +
+                X % TileWidth];
+}
+
+bool occlusionCuller::getOccluderRect(const glm::vec3 &Centre, float Radius,
+                                      screenRect &Rect) const {
+  // Must be wholly in front of the near plane, view space looks down -z
+  if (Centre.z + Radius > -MNear) {
+    return false;
+  }
+
+  // Rays within Radius / Distance radians of the centre hit the sphere, and
+  // perspective only stretches that cone on screen. Both scales match unless
+  // the projection's aspect ratio differs from the buffer's.
+  const float Distance = glm::length(Centre);
+  const float InnerRadius =
+      std::min(MScaleX, MScaleY) * (Radius / Distance) * float(M_SQRT1_2);
+  const float X = 0.5f * getWidth() + MScaleX * Centre.x / -Centre.z;
+  const float Y = 0.5f * getHeight() + MScaleY * Centre.y / -Centre.z;
+
+  // Only pixels wholly inside the square
+  Rect.X0 = std::max(0, int(std::ceil(X - InnerRadius)));
+  Rect.Y0 = std::max(0, int(std::ceil(Y - InnerRadius)));
+  Rect.X1 = std::min(int(getWidth()), int(std::floor(X + InnerRadius)));
+  Rect.Y1 = std::min(int(getHeight()), int(std::floor(Y + InnerRadius)));
+  Rect.Depth = Distance;
+  return Rect.X0 < Rect.X1 && Rect.Y0 < Rect.Y1;
+}
+
+bool occlusionCuller::getBoundsRect(const glm::vec3 &Centre, float Radius,
+                                    screenRect &Rect) const {
+  if (Centre.z + Radius > -MNear) {
+    return false;
+  }
+
+  // Projected extents of the view space bounding box are at its corners
+  float MinX = FLT_MAX, MaxX = -FLT_MAX, MinY = FLT_MAX, MaxY = -FLT_MAX;
+  for (float Z : {Centre.z - Radius, Centre.z + Radius}) {
+    for (float Side : {-Radius, Radius}) {
+      const float X = MScaleX * (Centre.x + Side) / -Z;
+      const float Y = MScaleY * (Centre.y + Side) / -Z;
+      MinX = std::min(MinX, X);
+      MaxX = std::max(MaxX, X);
+      MinY = std::min(MinY, Y);
+      MaxY = std::max(MaxY, Y);
+    }
+  }
+
+  // Every pixel the bounds touch
+  const float HalfWidth = 0.5f * getWidth(), HalfHeight = 0.5f * getHeight();
+  Rect.X0 = std::max(0, int(std::floor(HalfWidth + MinX)));
+  Rect.Y0 = std::max(0, int(std::floor(HalfHeight + MinY)));
+  Rect.X1 = std::min(int(getWidth()), int(std::ceil(HalfWidth + MaxX)));
+  Rect.Y1 = std::min(int(getHeight()), int(std::ceil(HalfHeight + MaxY)));
+  Rect.Depth = glm::length(Centre) - Radius;
+  return true;
+}
+
+void occlusionCuller::rasterize(const screenRect *Rects, size_t NumRects,
+                                unsigned TileY0, unsigned TileY1) {
+  const int BandY0 = TileY0 * TileHeight, BandY1 = TileY1 * TileHeight;
+  for (size_t R = 0; R < NumRects; R++) {
+    const screenRect &Rect = Rects[R];
+    const int Y0 = std::max(Rect.Y0, BandY0), Y1 = std::min(Rect.Y1, BandY1);
+    if (Y0 >= Y1) {
+      continue;
+    }
+
+    for (int TY = Y0 / TileHeight; TY * int(TileHeight) < Y1; TY++) {
+      for (int TX = Rect.X0 / TileWidth; TX * int(TileWidth) < Rect.X1;
+           TX++) {
+        float *Tile = &MDepth[(size_t(TY) * MTilesX + TX) * TilePixels];
+        const int TileX = TX * TileWidth, TileY = TY * TileHeight;
+        const int RowBegin = std::max(Y0, TileY) - TileY;
+        const int RowEnd = std::min(Y1, TileY + int(TileHeight)) - TileY;
+#if defined(__SSE2__)
+        // Rect depth in covered columns, FLT_MAX elsewhere so min() keeps
+        // the old depth
+        __m128 Depth[2];
+        for (unsigned Half = 0; Half < 2; Half++) {
+          const __m128 Mask =
+              getColumnMask(TileX + Half * 4, Rect.X0, Rect.X1);
+          Depth[Half] =
+              _mm_or_ps(_mm_and_ps(Mask, _mm_set1_ps(Rect.Depth)),
+                        _mm_andnot_ps(Mask, _mm_set1_ps(FLT_MAX)));
+        }
+        for (int Row = RowBegin; Row < RowEnd; Row++) {
+          float *Pixels = Tile + Row * TileWidth;
+          for (unsigned Half = 0; Half < 2; Half++) {
+            _mm_storeu_ps(Pixels + Half * 4,
+                          _mm_min_ps(_mm_loadu_ps(Pixels + Half * 4),
+                                     Depth[Half]));
+          }
+        }
+#else
+        const int Col0 = std::max(Rect.X0, TileX) - TileX;
+        const int Col1 = std::min(Rect.X1, TileX + int(TileWidth)) - TileX;
+        for (int Row = RowBegin; Row < RowEnd; Row++) {
+          for (int Col = Col0; Col < Col1; Col++) {
+            float &Pixel = Tile[Row * TileWidth + Col];
+            Pixel = std::min(Pixel, Rect.Depth);
+          }
+        }
+#endif
+      }
+    }
+  }
+
+  // Refresh the farthest depth of each tile in the band
+  for (unsigned TY = TileY0; TY < TileY1; TY++) {
+    for (unsigned TX = 0; TX < MTilesX; TX++) {
+      const size_t Tile = size_t(TY) * MTilesX + TX;
+      const float *Pixels = &MDepth[Tile * TilePixels];
+      MTileMax[Tile] = *std::max_element(Pixels, Pixels + TilePixels);
+    }
+  }
+}
+
+bool occlusionCuller::addOccluder(const glm::vec3 &Centre, float Radius) {
+  screenRect Rect;
+  if (!getOccluderRect(Centre, Radius, Rect)) {
+    return false;
+  }
+  rasterize(&Rect, 1, Rect.Y0 / TileHeight,
+            (Rect.Y1 + TileHeight - 1) / TileHeight);
+  return true;
+}
+
+bool occlusionCuller::isRectOccluded(const screenRect &Rect) const {
+  if (Rect.X0 >= Rect.X1 || Rect.Y0 >= Rect.Y1) {
+    // Off screen, leave it to frustum culling
+    return false;
+  }
+
+  for (int TY = Rect.Y0 / TileHeight; TY * int(TileHeight) < Rect.Y1; TY++) {
+    for (int TX = Rect.X0 / TileWidth; TX * int(TileWidth) < Rect.X1; TX++) {
+      const size_t TileIdx = size_t(TY) * MTilesX + TX;
+      // Everything in the tile is nearer
+      if (MTileMax[TileIdx] < Rect.Depth) {
+        continue;
+      }
+
+      const float *Tile = &MDepth[TileIdx * TilePixels];
+      const int TileX = TX * TileWidth, TileY = TY * TileHeight;
+      const int RowBegin = std::max(Rect.Y0, TileY) - TileY;
+      const int RowEnd = std::min(Rect.Y1, TileY + int(TileHeight)) - TileY;
+#if defined(__SSE2__)
+      const __m128 Depth = _mm_set1_ps(Rect.Depth);
+      const __m128 Masks[2] = {getColumnMask(TileX, Rect.X0, Rect.X1),
+                               getColumnMask(TileX + 4, Rect.X0, Rect.X1)};
+      for (int Row = RowBegin; Row < RowEnd; Row++) {
+        const float *Pixels = Tile + Row * TileWidth;
+        for (unsigned Half = 0; Half < 2; Half++) {
+          const __m128 Farther =
+              _mm_cmpge_ps(_mm_loadu_ps(Pixels + Half * 4), Depth);
+          if (_mm_movemask_ps(_mm_and_ps(Farther, Masks[Half]))) {
+            return false;
+          }
+        }
+      }
+#else
+      const int Col0 = std::max(Rect.X0, TileX) - TileX;
+      const int Col1 = std::min(Rect.X1, TileX + int(TileWidth)) - TileX;
+      for (int Row = RowBegin; Row < RowEnd; Row++) {
+        for (int Col = Col0; Col < Col1; Col++) {
+          if (Tile[Row * TileWidth + Col] >= Rect.Depth) {
+            return false;
+          }
+        }
+      }
+#endif
+    }
+  }
+  return true;
+}
+
+bool occlusionCuller::isOccluded(const glm::vec3 &Centre, float Radius) const {
+  screenRect Rect;
+  return getBoundsRect(Centre, Radius, Rect) && isRectOccluded(Rect);
+}
+
+size_t occlusionCuller::cull(const ballInstance *Balls, size_t NumBalls,
+                             float Radius, const glm::mat4 &View,
+                             const glm::mat4 &Proj, workerPool &Pool,
+                             ballInstance *Out) {
+  TRACE_ZONE("occlusion cull");
+  setProjection(Proj);
+  const size_t NumChunks = (NumBalls + ChunkSize - 1) / ChunkSize;
+  MDistance.resize(NumBalls);
+  MCandidates.resize(NumChunks * MNumOccluders);
+  MVisible.resize(NumChunks * ChunkSize);
+  MChunkCounts.resize(NumChunks);
+
+  // Nearest balls of each chunk which could occlude, as candidates for the
+  // nearest overall
+  Pool.run(NumChunks, MinChunksPerThread, [&](size_t Begin, size_t End) {
+    TRACE_ZONE("occluder select");
+    for (size_t C = Begin; C < End; C++) {
+      const size_t First = C * ChunkSize;
+      const size_t Last = std::min(First + ChunkSize, NumBalls);
+      unsigned *Candidates = &MCandidates[C * MNumOccluders];
+      unsigned *Visible = &MVisible[First];
+      size_t NumCandidates = 0;
+      for (size_t i = First; i < Last; i++) {
+        const glm::vec3 Centre = getViewCentre(Balls[i], View);
+        const float BallRadius = Balls[i].OffsetScale[3] * Radius;
+        if (Centre.z + BallRadius <= -MNear) {
+          MDistance[i] = glm::length(Centre);
+          Visible[NumCandidates++] = i;
+        }
+      }
+      // Borrow the chunk's range of MVisible to sort
+      auto Nearer = [&](unsigned A, unsigned B) {
+        return MDistance[A] < MDistance[B];
+      };
+      const size_t Keep = std::min<size_t>(NumCandidates, MNumOccluders);
+      std::nth_element(Visible, Visible + Keep, Visible + NumCandidates,
+                       Nearer);
+      std::copy(Visible, Visible + Keep, Candidates);
+      std::fill(Candidates + Keep, Candidates + MNumOccluders, NoCandidate);
+    }
+  });
+
+  auto CandidatesEnd = std::remove(MCandidates.begin(), MCandidates.end(),
+                                   NoCandidate);
+  const size_t NumOccluders = std::min<size_t>(
+      CandidatesEnd - MCandidates.begin(), MNumOccluders);
+  std::nth_element(MCandidates.begin(), MCandidates.begin() + NumOccluders,
+                   CandidatesEnd, [&](unsigned A, unsigned B) {
+                     return MDistance[A] < MDistance[B];
+                   });
+  MOccluders.clear();
+  for (size_t i = 0; i < NumOccluders; i++) {
+    const ballInstance &Ball = Balls[MCandidates[i]];
+    screenRect Rect;
+    if (getOccluderRect(getViewCentre(Ball, View),
+                        Ball.OffsetScale[3] * Radius, Rect)) {
+      MOccluders.push_back(Rect);
+    }
+  }
+
+  // Each task owns a band of tile rows, so needs no synchronization
+  Pool.run(MTilesY, MinTileRowsPerThread, [&](size_t Begin, size_t End) {
+    TRACE_ZONE("occluder rasterize");
+    std::fill(MDepth.begin() + Begin * MTilesX * TilePixels,
+              MDepth.begin() + End * MTilesX * TilePixels, FLT_MAX);
+    rasterize(MOccluders.data(), MOccluders.size(), Begin, End);
+  });
+
+  // Test every ball, recording the visible balls of each chunk
+  Pool.run(NumChunks, MinChunksPerThread, [&](size_t Begin, size_t End) {
+    TRACE_ZONE("occlusion test");
+    for (size_t C = Begin; C < End; C++) {
+      const size_t First = C * ChunkSize;
+      const size_t Last = std::min(First + ChunkSize, NumBalls);
+      unsigned *Visible = &MVisible[First];
+      size_t NumVisible = 0;
+      for (size_t i = First; i < Last; i++) {
+        if (!isOccluded(getViewCentre(Balls[i], View),
+                        Balls[i].OffsetScale[3] * Radius)) {
+          Visible[NumVisible++] = i;
+        }
+      }
+      MChunkCounts[C] = NumVisible;
+    }
+  });
+
+  // Exclusive prefix sum turns the counts into offsets in Out
+  size_t NumVisible = 0;
+  for (size_t &Count : MChunkCounts) {
+    size_t ChunkVisible = Count;
+    Count = NumVisible;
+    NumVisible += ChunkVisible;
+  }
+
+  Pool.run(NumChunks, MinChunksPerThread, [&](size_t Begin, size_t End) {
+    TRACE_ZONE("occlusion compact");
+    for (size_t C = Begin; C < End; C++) {
+      const size_t ChunkEnd =
+          C + 1 < NumChunks ? MChunkCounts[C + 1] : NumVisible;
+      const unsigned *Visible = &MVisible[C * ChunkSize];
+      for (size_t Dst = MChunkCounts[C]; Dst < ChunkEnd; Dst++) {
+        std::memcpy(&Out[Dst], &Balls[*Visible++], sizeof(ballInstance));
+      }
+    }
+  });
+  return NumVisible;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include "balls.h"
+#include "workers.h"
+#include <glm/glm.hpp>
+#include <vector>
+// clang-format on
+
+// Hides balls behind nearer ones on the CPU before they are submitted. The
+// nearest balls are rasterized as occluders into a small depth buffer, then
+// the screen bounds of every ball are tested against it.
+//
+// Depth is the distance from the camera along the ray through a pixel, which
+// lets both sides be conservative for spheres. An occluder writes the
+// distance to its centre over a square inscribed in its silhouette, where
+// every ray hits it no further away, and a ball is hidden only if that is
+// nearer than the closest point of the ball at every pixel its bounds touch.
+//
+// The buffer is stored in tiles of 8x4 pixels, two SSE vectors per row, and
+// the farthest depth of each tile is kept so most tests never read pixels.
+// Occluders are rasterized by bands of tile rows on worker threads.
+struct occlusionCuller {
+  // Width and Height are rounded up to whole tiles
+  occlusionCuller(unsigned Width, unsigned Height, unsigned NumOccluders = 64);
+
+  // Writes the balls of Balls which aren't hidden by its nearest balls to Out
+  // and returns how many were written, preserving their order. Radius is that
+  // of the sphere the balls scale, and Proj must be a symmetric perspective
+  // projection.
+  size_t cull(const ballInstance *Balls, size_t NumBalls, float Radius,
+              const glm::mat4 &View, const glm::mat4 &Proj, workerPool &Pool,
+              ballInstance *Out);
+
+  // Building blocks of cull(), spheres are in view space. The projection must
+  // be set before anything is rasterized or tested.
+  void setProjection(const glm::mat4 &Proj);
+  void clear();
+  // Rasterizes a sphere as an occluder, returns false if it can't occlude
+  bool addOccluder(const glm::vec3 &Centre, float Radius);
+  bool isOccluded(const glm::vec3 &Centre, float Radius) const;
+
+  // Depth of a pixel, FLT_MAX where no occluder was rasterized
+  float getDepth(unsigned X, unsigned Y) const;
+  unsigned getWidth() const { return MTilesX * TileWidth; }
+  unsigned getHeight() const { return MTilesY * TileHeight; }
+  unsigned getNumOccluders() const { return MNumOccluders; }
+
+  static constexpr unsigned TileWidth = 8;
+  static constexpr unsigned TileHeight = 4;
+
+private:
+  // Pixels [X0, X1) x [Y0, Y1) at distance Depth
+  struct screenRect {
+    int X0, Y0, X1, Y1;
+    float Depth;
+  };
+
+  // Squares of occluders which cover whole pixels, false if there are none
+  bool getOccluderRect(const glm::vec3 &Centre, float Radius,
+                       screenRect &Rect) const;
+  // Pixels touched by a ball with the distance to its nearest point, false
+  // if it reaches the near plane and can't be tested
+  bool getBoundsRect(const glm::vec3 &Centre, float Radius,
+                     screenRect &Rect) const;
+  // Writes occluders clipped to tile rows [TileY0, TileY1)
+  void rasterize(const screenRect *Rects, size_t NumRects, unsigned TileY0,
+                 unsigned TileY1);
+  bool isRectOccluded(const screenRect &Rect) const;
+
+  unsigned MTilesX;
+  unsigned MTilesY;
+  unsigned MNumOccluders;
+  // Tile major, rows of TileWidth pixels within a tile
+  std::vector<float> MDepth;
+  std::vector<float> MTileMax;
+
+  // Scales view space x/y over -z to pixels, and the near plane distance
+  float MScaleX;
+  float MScaleY;
+  float MNear;
+
+  // Per frame scratch, reused to avoid allocating
+  std::vector<float> MDistance;
+  std::vector<unsigned> MCandidates;
+  std::vector<screenRect> MOccluders;
+  std::vector<unsigned> MVisible;
+  std::vector<size_t> MChunkCounts;
+};
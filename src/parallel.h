@@ -0,0 +1,34 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Calls Func(Begin, End) over contiguous ranges that partition [0, Count),
+// one range per hardware thread. Ranges are at least MinPerThread long, so
+// small workloads run inline on the calling thread.
+template <typename Fn>
+void parallelFor(size_t Count, size_t MinPerThread, Fn &&Func) {
+  size_t NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  NumThreads = std::min(NumThreads, Count / std::max<size_t>(MinPerThread, 1));
+  if (NumThreads <= 1) {
+    Func(size_t(0), Count);
+    return;
+  }
+
+  std::vector<std::thread> Workers;
+  Workers.reserve(NumThreads - 1);
+  const size_t Chunk = (Count + NumThreads - 1) / NumThreads;
+  for (size_t T = 1; T < NumThreads; T++) {
+    size_t Begin = std::min(T * Chunk, Count);
+    size_t End = std::min(Begin + Chunk, Count);
+    Workers.emplace_back([&Func, Begin, End]() { Func(Begin, End); });
+  }
+  // Calling thread takes the first range
+  Func(size_t(0), std::min(Chunk, Count));
+
+  for (auto &Worker : Workers) {
+    Worker.join();
+  }
+}
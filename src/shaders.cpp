@@ -1,12 +1,131 @@
 // Copyright (c) 2025-2026 Ewan Crawford
 #include "shaders.h"
+#include "trace.h"
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <unistd.h>
 #include <vector>
 
 namespace {
-void createShader(std::string Filename, GLuint ShaderID) {
+// Program binaries are stored in Dir, empty when caching is disabled
+struct shaderCache {
+  std::string Dir;
+  // Hash of the GL renderer and version every key starts from
+  uint64_t Seed = 0;
+  shaderCacheStats Stats = {};
+} Cache;
+
+shaderCompileStats CompileStats = {};
+
+// From GL_KHR_parallel_shader_compile, which is newer than GLEW 1.13. The
+// ARB extension has the same value.
+constexpr GLenum CompletionStatus = 0x91B1;
+typedef void(GLAPIENTRY *maxShaderCompilerThreadsFn)(GLuint Count);
+
+// Prefix of each cache file, followed by the program binary
+struct cacheHeader {
+  char Magic[4];
+  uint32_t Format;   // Binary format from glGetProgramBinary
+  uint64_t Key;      // Guards against a file renamed over another
+  uint64_t Length;   // Bytes of binary after the header
+  double CompileMs;  // Time to compile and link the sources
+};
+constexpr char CacheMagic[4] = {'G', 'S', 'P', '2'};
+
+double getElapsedMs(std::chrono::steady_clock::time_point Start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - Start)
+      .count();
+}
+
+// 64-bit FNV-1a
+uint64_t hashBytes(uint64_t Hash, const void *Data, size_t Size) {
+  const unsigned char *Bytes = static_cast<const unsigned char *>(Data);
+  for (size_t i = 0; i < Size; i++) {
+    Hash = (Hash ^ Bytes[i]) * 0x100000001b3ull;
+  }
+  return Hash;
+}
+
+uint64_t hashString(uint64_t Hash, const std::string &Str) {
+  // Length first so consecutive strings can't run together
+  const uint64_t Size = Str.size();
+  Hash = hashBytes(Hash, &Size, sizeof(Size));
+  return hashBytes(Hash, Str.data(), Str.size());
+}
+
+std::string getCachePath(uint64_t Key) {
+  char Name[32];
+  snprintf(Name, sizeof(Name), "%016llx.bin",
+           static_cast<unsigned long long>(Key));
+  return Cache.Dir + "/" + Name;
+}
+
+// Reads the binary of a cache entry, false if there's no valid entry
+bool readCachedProgram(uint64_t Key, cacheHeader &Header,
+                       std::vector<char> &Binary) {
+  std::ifstream File(getCachePath(Key), std::ios::binary);
+  if (!File.is_open()) {
+    return false;
+  }
+  if (File.read(reinterpret_cast<char *>(&Header), sizeof(Header)) &&
+      std::memcmp(Header.Magic, CacheMagic, sizeof(CacheMagic)) == 0 &&
+      Header.Key == Key) {
+    Binary.resize(Header.Length);
+    File.read(Binary.data(), Binary.size());
+  }
+  if (!File || Binary.empty()) {
+    Cache.Stats.Rejected++;
+    return false;
+  }
+  return true;
+}
+
+void storeCachedProgram(uint64_t Key, GLuint ProgramID, double CompileMs) {
+  GLint Length = 0;
+  glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &Length);
+  if (Length <= 0) {
+    return;
+  }
+  std::vector<char> Binary(Length);
+  cacheHeader Header;
+  std::memcpy(Header.Magic, CacheMagic, sizeof(CacheMagic));
+  GLenum Format = 0;
+  glGetProgramBinary(ProgramID, Length, nullptr, &Format, Binary.data());
+  Header.Format = Format;
+  Header.Key = Key;
+  Header.Length = Binary.size();
+  Header.CompileMs = CompileMs;
+
+  // Written aside then renamed, so concurrent instances never read a
+  // partial entry
+  const std::string Path = getCachePath(Key);
+  const std::string TempPath = Path + "." + std::to_string(getpid());
+  {
+    std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+    File.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+    File.write(Binary.data(), Binary.size());
+    if (!File) {
+      std::cerr << "Warning: could not write shader cache " << TempPath
+                << std::endl;
+      return;
+    }
+  }
+  std::error_code Error;
+  std::filesystem::rename(TempPath, Path, Error);
+  if (Error) {
+    std::filesystem::remove(TempPath, Error);
+  }
+}
+
+std::string readShader(const std::string &Filename) {
   // Read shader from file
   // CMake copies shaders to <build_dir>/shaders/
   std::string ShaderPath = std::string("shaders/") + Filename;
@@ -17,15 +136,11 @@ void createShader(std::string Filename, GLuint ShaderID) {
 
   std::stringstream sstr;
   sstr << ShaderStream.rdbuf();
-  ShaderStream.close();
-
-  // Compile Shader
-  std::string ShaderCode = sstr.str();
-  char const *ShaderSourceCStr = ShaderCode.c_str();
-  glShaderSource(ShaderID, 1, &ShaderSourceCStr, nullptr);
-  glCompileShader(ShaderID);
+  return sstr.str();
+}
 
-  // Check Shader
+// Throws with the log of ShaderID if it failed to compile
+void checkShader(GLuint ShaderID) {
   GLint Result = GL_FALSE;
   glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
   if (Result != GL_TRUE) {
@@ -45,18 +160,8 @@ void createShader(std::string Filename, GLuint ShaderID) {
   }
 }
 
-GLuint loadShaders(std::string VertexShader, std::string FragShader) {
-  GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-  createShader(VertexShader, VertexShaderID);
-
-  GLuint FragShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-  createShader(FragShader, FragShaderID);
-
-  GLuint ProgramID = glCreateProgram();
-  glAttachShader(ProgramID, VertexShaderID);
-  glAttachShader(ProgramID, FragShaderID);
-  glLinkProgram(ProgramID);
-
+// Throws with the log of ProgramID if it failed to link
+void checkProgram(GLuint ProgramID) {
   GLint Result = GL_FALSE;
   glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
   if (Result != GL_TRUE) {
@@ -73,26 +178,207 @@ GLuint loadShaders(std::string VertexShader, std::string FragShader) {
       throw std::runtime_error("Shader program could not link");
     }
   }
+}
 
-  glDetachShader(ProgramID, VertexShaderID);
-  glDetachShader(ProgramID, FragShaderID);
+shaderProgram startShaders(std::string VertexShader,
+                           std::vector<std::string> FragShaders) {
+  return shaderProgram({{GL_VERTEX_SHADER, {VertexShader}},
+                        {GL_FRAGMENT_SHADER, FragShaders}});
+}
+} // namespace
 
-  glDeleteShader(VertexShaderID);
-  glDeleteShader(FragShaderID);
+void setShaderCache(const std::string &Dir) {
+  Cache.Dir.clear();
+  if (Dir.empty()) {
+    return;
+  }
+  // Drivers may support the API but no formats, which is common with
+  // software renderers
+  GLint NumFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &NumFormats);
+  std::error_code Error;
+  std::filesystem::create_directories(Dir, Error);
+  if (NumFormats == 0 || Error) {
+    return;
+  }
 
-  return ProgramID;
+  Cache.Dir = Dir;
+  // Binaries are only valid for the driver which produced them
+  auto GLString = [](GLenum Name) {
+    const GLubyte *Str = glGetString(Name);
+    return Str ? std::string(reinterpret_cast<const char *>(Str)) : "";
+  };
+  Cache.Seed = hashString(0xcbf29ce484222325ull, GLString(GL_RENDERER));
+  Cache.Seed = hashString(Cache.Seed, GLString(GL_VERSION));
 }
 
-} // namespace
+const shaderCacheStats &getShaderCacheStats() { return Cache.Stats; }
+
+void enableParallelShaderCompile() {
+  bool Supported = false;
+  GLint NumExtensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &NumExtensions);
+  for (GLint i = 0; i < NumExtensions && !Supported; i++) {
+    const char *Name =
+        reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+    Supported = Name && (!std::strcmp(Name, "GL_KHR_parallel_shader_compile") ||
+                         !std::strcmp(Name, "GL_ARB_parallel_shader_compile"));
+  }
+  auto MaxThreads = reinterpret_cast<maxShaderCompilerThreadsFn>(
+      glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+  if (!MaxThreads) {
+    MaxThreads = reinterpret_cast<maxShaderCompilerThreadsFn>(
+        glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+  }
+  if (!Supported || !MaxThreads) {
+    return;
+  }
+  // As many threads as the implementation wants
+  MaxThreads(0xFFFFFFFF);
+  CompileStats.Parallel = true;
+}
+
+const shaderCompileStats &getShaderCompileStats() { return CompileStats; }
+
+shaderProgram::shaderProgram(std::vector<shaderStage> Stages)
+    : MStages(std::move(Stages)), MReady(false) {
+  TRACE_ZONE("startShaders");
+  // Sources are read even on a cache hit, as they key the cache
+  MKey = Cache.Seed;
+  for (const shaderStage &Stage : MStages) {
+    MKey = hashBytes(MKey, &Stage.Type, sizeof(Stage.Type));
+    MCode.emplace_back();
+    for (const std::string &Filename : Stage.Filenames) {
+      MCode.back().push_back(readShader(Filename));
+      MKey = hashString(MKey, MCode.back().back());
+    }
+  }
+
+  cacheHeader Header;
+  std::vector<char> Binary;
+  if (!Cache.Dir.empty() && readCachedProgram(MKey, Header, Binary)) {
+    // Only checked by get(), the driver may still be loading it
+    auto Start = std::chrono::steady_clock::now();
+    MProgram = glCreateProgram();
+    glProgramBinary(MProgram, Header.Format, Binary.data(), Binary.size());
+    MIssueMs = getElapsedMs(Start);
+    MFromCache = true;
+    MCachedCompileMs = Header.CompileMs;
+    return;
+  }
+  compile();
+}
+
+void shaderProgram::compile() {
+  TRACE_ZONE("compileShaders");
+  auto Start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < MStages.size(); i++) {
+    GLuint ShaderID = glCreateShader(MStages[i].Type);
+    MShaders.push_back(ShaderID);
+    std::vector<const char *> ShaderSourceCStrs;
+    for (const std::string &Code : MCode[i]) {
+      ShaderSourceCStrs.push_back(Code.c_str());
+    }
+    glShaderSource(ShaderID, ShaderSourceCStrs.size(),
+                   ShaderSourceCStrs.data(), nullptr);
+    glCompileShader(ShaderID);
+  }
+
+  MProgram = glCreateProgram();
+  for (GLuint ShaderID : MShaders) {
+    glAttachShader(MProgram, ShaderID);
+  }
+  if (!Cache.Dir.empty()) {
+    glProgramParameteri(MProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+  // Linking doesn't wait for the stages to compile
+  glLinkProgram(MProgram);
+  MIssueMs = getElapsedMs(Start);
+}
+
+GLuint shaderProgram::get() {
+  if (MReady) {
+    return MProgram;
+  }
+  TRACE_ZONE("waitShaders");
+  MReady = true;
+  CompileStats.Programs++;
+  auto WaitStart = std::chrono::steady_clock::now();
+  if (CompileStats.Parallel) {
+    // Never blocks, unlike the link status
+    GLint Complete = GL_FALSE;
+    glGetProgramiv(MProgram, CompletionStatus, &Complete);
+    CompileStats.NotReady += Complete != GL_TRUE;
+  }
+
+  const bool Caching = !Cache.Dir.empty();
+  GLint Linked = GL_FALSE;
+  glGetProgramiv(MProgram, GL_LINK_STATUS, &Linked);
+  if (MFromCache && Linked == GL_TRUE) {
+    // Loading is only the binary issued and waited on, not any work done
+    // between the two
+    const double WaitMs = getElapsedMs(WaitStart);
+    Cache.Stats.Hits++;
+    Cache.Stats.SavedMs += MCachedCompileMs - (MIssueMs + WaitMs);
+    CompileStats.WaitMs += WaitMs;
+    return MProgram;
+  }
+  if (Caching) {
+    Cache.Stats.Misses++;
+  }
+  auto CheckStart = WaitStart;
+  if (MFromCache) {
+    // Usually a driver update, the sources are compiled instead
+    Cache.Stats.Rejected++;
+    glDeleteProgram(MProgram);
+    compile();
+    CheckStart = std::chrono::steady_clock::now();
+  }
+
+  // Failed stages explain a failed link best
+  for (GLuint ShaderID : MShaders) {
+    checkShader(ShaderID);
+  }
+  checkProgram(MProgram);
+  // Time the compile kept this thread, issuing it and waiting for it, but
+  // not the work done between the two
+  const double CompileMs = MIssueMs + getElapsedMs(CheckStart);
+  CompileStats.WaitMs += getElapsedMs(WaitStart);
+
+  for (GLuint ShaderID : MShaders) {
+    glDetachShader(MProgram, ShaderID);
+    glDeleteShader(ShaderID);
+  }
+  MShaders.clear();
+
+  if (Caching) {
+    storeCachedProgram(MKey, MProgram, CompileMs);
+  }
+  return MProgram;
+}
+
+shaderProgram startSphereShaders() {
+  return startShaders("sphere_vertex.glsl", {"sphere_frag.glsl", "phong.glsl"});
+}
+
+shaderProgram startSphereImpostorShaders() {
+  return startShaders("sphere_impostor_vertex.glsl",
+                      {"sphere_impostor_frag.glsl", "phong.glsl"});
+}
 
-GLuint loadSphereShaders() {
-  return loadShaders("sphere_vertex.glsl", "sphere_frag.glsl");
+shaderProgram startSphereTessellationShaders() {
+  return shaderProgram(
+      {{GL_VERTEX_SHADER, {"sphere_tess_vertex.glsl"}},
+       {GL_TESS_CONTROL_SHADER, {"sphere_tess_control.glsl"}},
+       {GL_TESS_EVALUATION_SHADER, {"sphere_tess_eval.glsl"}},
+       {GL_FRAGMENT_SHADER, {"sphere_frag.glsl", "phong.glsl"}}});
 }
 
-GLuint loadSkyboxShaders() {
-  return loadShaders("skybox_vertex.glsl", "skybox_frag.glsl");
+shaderProgram startSkyboxShaders() {
+  return startShaders("skybox_vertex.glsl", {"skybox_frag.glsl"});
 }
 
-GLuint loadTextShaders() {
-  return loadShaders("font_vertex.glsl", "font_frag.glsl");
+shaderProgram startTextShaders() {
+  return startShaders("font_vertex.glsl", {"font_frag.glsl"});
 }
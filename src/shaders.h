@@ -2,7 +2,86 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
 
-GLuint loadSphereShaders();
-GLuint loadSkyboxShaders();
-GLuint loadTextShaders();
+// Programs loaded since startup
+struct shaderCacheStats {
+  unsigned Hits;
+  unsigned Misses;
+  unsigned Rejected; // Misses with an entry the driver or file didn't accept
+  // Compile time of the hits, less the time to load them. Both are the time
+  // spent issuing and waiting for the work, not any work done meanwhile.
+  double SavedMs;
+};
+
+// Programs waited on by shaderProgram::get() since startup
+struct shaderCompileStats {
+  unsigned Programs;
+  unsigned NotReady; // Still compiling when first needed, if known
+  double WaitMs;
+  bool Parallel; // Driver compiles on its own threads
+};
+
+// Caches linked program binaries in Dir, keyed by a hash of the sources and
+// the GL renderer and version. Empty Dir disables the cache, as does a
+// driver with no binary formats. Needs a current context.
+void setShaderCache(const std::string &Dir);
+const shaderCacheStats &getShaderCacheStats();
+
+// Lets the driver compile and link on as many threads as it likes with
+// GL_KHR_parallel_shader_compile, or the ARB version, when supported
+void enableParallelShaderCompile();
+const shaderCompileStats &getShaderCompileStats();
+
+// Source files compiled into one stage of a program, the first has the
+// #version directive and the rest are libraries of functions it declares
+struct shaderStage {
+  GLenum Type;
+  std::vector<std::string> Filenames;
+};
+
+// Program whose compile and link, or cached binary, is issued on
+// construction without checking the result. Drivers which compile on their
+// own threads carry on while the caller does other work, until get() first
+// needs the program.
+struct shaderProgram {
+  shaderProgram() = default;
+  explicit shaderProgram(std::vector<shaderStage> Stages);
+
+  shaderProgram(const shaderProgram &) = delete;
+  shaderProgram &operator=(const shaderProgram &) = delete;
+  shaderProgram(shaderProgram &&) = default;
+  shaderProgram &operator=(shaderProgram &&) = default;
+
+  // Waits for the program and checks it, throwing if it failed to compile
+  // or link. Later calls return the same program, 0 if none was started.
+  GLuint get();
+
+private:
+  // Issues the compile and link of every stage from source
+  void compile();
+
+  std::vector<shaderStage> MStages;
+  std::vector<std::vector<std::string>> MCode;
+  std::vector<GLuint> MShaders;
+  GLuint MProgram = 0;
+  bool MReady = true;
+
+  // Cache key, and the compile time stored with a cached binary
+  uint64_t MKey = 0;
+  bool MFromCache = false;
+  double MCachedCompileMs = 0.0;
+  // Time spent issuing the compile or cached binary
+  double MIssueMs = 0.0;
+};
+
+shaderProgram startSphereShaders();
+// Ray-cast sphere drawn on a camera facing quad
+shaderProgram startSphereImpostorShaders();
+// Icosahedron patches refined by tessellation shaders, requires GL 4.0
+shaderProgram startSphereTessellationShaders();
+shaderProgram startSkyboxShaders();
+shaderProgram startTextShaders();
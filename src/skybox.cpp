@@ -1,13 +1,10 @@
 // Copyright (c) 2025-2026 Ewan Crawford
 
 #include "skybox.h"
-#include <GL/gl.h>
+#include "assets.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <stdexcept>
 #include <string>
 
-#include <stb_image.h>
-
 skybox::skybox() {
   // clang-format off
   MVertices = std::array<float, MNumVertices> {
@@ -39,7 +36,7 @@ skybox::skybox() {
   // clang-format on
 }
 
-unsigned int skybox::loadCubemap() {
+textureFiles skybox::loadCubemap(assetLoader &Loader, bool UseCooked) {
   // Loads a cubemap texture from 6 individual texture images
   // +X (right)
   // -X (left)
@@ -47,36 +44,11 @@ unsigned int skybox::loadCubemap() {
   // -Y (bottom)
   // +Z (front)
   // -Z (back)
-
-  constexpr unsigned CubeFaces = 6;
-  std::string Faces[CubeFaces] = {
+  const std::vector<std::string> Faces = {
       "textures/skybox_px.png", "textures/skybox_nx.png",
       "textures/skybox_py.png", "textures/skybox_ny.png",
       "textures/skybox_pz.png", "textures/skybox_nz.png"};
-
-  unsigned int TextureID;
-  glGenTextures(1, &TextureID);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, TextureID);
-
-  for (unsigned int i = 0; i < CubeFaces; i++) {
-    int Width, Height, NrComponents;
-    unsigned char *Data =
-        stbi_load(Faces[i].c_str(), &Width, &Height, &NrComponents, 0);
-    if (!Data) {
-      throw std::runtime_error(std::string("Texture failed to load at path: ") +
-                               Faces[i]);
-    }
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, Width, Height,
-                 0, GL_RGBA, GL_UNSIGNED_BYTE, Data);
-    stbi_image_free(Data);
-  }
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-  return TextureID;
+  return Loader.loadTexture("textures/skybox.gstex", Faces, 4, UseCooked);
 }
 
 glm::mat4 skybox::getModelMatrix() const {
@@ -4,6 +4,9 @@
 #include <array>
 #include <glm/glm.hpp>
 
+struct assetLoader;
+struct textureFiles;
+
 struct skybox {
   skybox();
 
@@ -13,7 +16,8 @@ struct skybox {
   unsigned getIndexSize() const { return MNumIndices * sizeof(unsigned); }
   glm::mat4 getModelMatrix() const;
 
-  static unsigned int loadCubemap();
+  // Queues the cubemap on Loader, cooked if UseCooked and it has been
+  static textureFiles loadCubemap(assetLoader &Loader, bool UseCooked);
 
   static constexpr unsigned MNumIndices = 12 * 3;
   static constexpr unsigned MNumVertices = 9 * 3;
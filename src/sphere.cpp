@@ -3,123 +3,466 @@
 // clang-format off
 #include <GL/glew.h>
 #include "sphere.h"
+#include "assets.h"
+#include "indices.h"
+#include "parallel.h"
+#include "trace.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <mutex>
 #include <stdexcept>
 #include <string>
-
-#include <stb_image.h>
+#include <unordered_map>
 // clang-format on
 
+namespace {
+// Minimum number of vertices generated per thread, below which spawning a
+// thread costs more than it saves
+constexpr size_t MinVerticesPerThread = 1 << 14;
+// Vertices this close to the poles have no defined longitude
+constexpr float PoleEpsilon = 1.0e-6f;
+// Marks a vertex with no copy on the far side of the UV seam
+constexpr unsigned NoCopy = ~0u;
+} // namespace
+
+size_t getUVTriangles(unsigned NumSectors, unsigned NumStacks) {
+  return size_t(2) * NumSectors * (NumStacks - 1);
+}
+
+const char *getMeshName(meshType Mesh) {
+  switch (Mesh) {
+  case meshType::UV:
+    return "uv";
+  case meshType::Ico:
+    return "ico";
+  case meshType::Cube:
+    return "cube";
+  }
+  return "unknown";
+}
+
 // From https://www.songho.ca/opengl/gl_sphere.html#sphere
+//
+// Stack rows are independent, so they're generated in parallel straight into
+// presized buffers. Sector sin/cos are tabulated once and the rotation of the
+// north pole from +Z to +Y is folded into the writes. Output matches computing
+// the trigonometry per vertex and rotating in a second pass, except that the
+// sign of zero components may differ.
 void sphere::buildVertices() {
+  TRACE_ZONE("sphere::buildVertices");
   const float SectorStep = 2 * M_PI / MNumSectors;
   const float StackStep = M_PI / MNumStacks;
   const float InvRadius = 1.0f / MRadius;
-  for (unsigned StackIdx = 0; StackIdx <= MNumStacks; ++StackIdx) {
-    const float StackAngle = (M_PI / 2) - (StackIdx * StackStep);
-    const float XY = MRadius * cosf(StackAngle);
-    const float Z = MRadius * sinf(StackAngle);
 
-    for (unsigned SectorIdx = 0; SectorIdx <= MNumSectors; ++SectorIdx) {
-      const float SectorAngle = SectorIdx * SectorStep;
-
-      // Vertex position
-      const float X = XY * cosf(SectorAngle); // r * cos(u) * cos(v)
-      const float Y = XY * sinf(SectorAngle); // r * cos(u) * sin(v)
-      MVertices.push_back(X);
-      MVertices.push_back(Y);
-      MVertices.push_back(Z);
-
-      // normals
-      const float NormalX = X * InvRadius;
-      const float NormalY = Y * InvRadius;
+  const unsigned RowLength = MNumSectors + 1;
+  const size_t NumVertices = size_t(MNumStacks + 1) * RowLength;
+  MNumVertices = NumVertices;
+  MDescription = "uv " + std::to_string(MNumStacks) + "x" +
+                 std::to_string(MNumSectors);
+  MVertices.resize(NumVertices * 3);
+  MNormals.resize(NumVertices * 3);
+  MTexCoords.resize(NumVertices * 2);
+  // 1 triangle per sector on the first and last stacks, 2 on the others
+  MIndices.resize(size_t(MNumStacks - 1) * MNumSectors * 2 * 3);
+
+  std::vector<float> SectorCos(RowLength);
+  std::vector<float> SectorSin(RowLength);
+  for (unsigned SectorIdx = 0; SectorIdx <= MNumSectors; ++SectorIdx) {
+    const float SectorAngle = SectorIdx * SectorStep;
+    SectorCos[SectorIdx] = cosf(SectorAngle);
+    SectorSin[SectorIdx] = sinf(SectorAngle);
+  }
+
+  auto BuildRows = [&](size_t FirstStack, size_t LastStack) {
+    TRACE_ZONE("sphere::buildVertices rows");
+    const float *__restrict Cos = SectorCos.data();
+    const float *__restrict Sin = SectorSin.data();
+    for (size_t StackIdx = FirstStack; StackIdx < LastStack; ++StackIdx) {
+      const float StackAngle = (M_PI / 2) - (StackIdx * StackStep);
+      const float XY = MRadius * cosf(StackAngle);
+      const float Z = MRadius * sinf(StackAngle);
       const float NormalZ = Z * InvRadius;
-      MNormals.push_back(NormalX);
-      MNormals.push_back(NormalY);
-      MNormals.push_back(NormalZ);
-
-      // Texture coordinates
-      float U = (float)SectorIdx / MNumSectors;
-      float V = (float)StackIdx / MNumStacks;
-      MTexCoords.push_back(U);
-      MTexCoords.push_back(V);
+      const float V = (float)StackIdx / MNumStacks;
+
+      const size_t RowStart = StackIdx * RowLength;
+      float *__restrict Vertices = MVertices.data() + RowStart * 3;
+      float *__restrict Normals = MNormals.data() + RowStart * 3;
+      float *__restrict TexCoords = MTexCoords.data() + RowStart * 2;
+
+      // Branch free so it can be auto-vectorized
+      for (unsigned SectorIdx = 0; SectorIdx < RowLength; ++SectorIdx) {
+        // Vertex position, before rotation
+        const float X = XY * Cos[SectorIdx]; // r * cos(u) * cos(v)
+        const float Y = XY * Sin[SectorIdx]; // r * cos(u) * sin(v)
+
+        // Rotated so north pole is +Y, (x, y, z) -> (x, z, -y)
+        Vertices[SectorIdx * 3] = X;
+        Vertices[SectorIdx * 3 + 1] = Z;
+        Vertices[SectorIdx * 3 + 2] = -Y;
+
+        Normals[SectorIdx * 3] = X * InvRadius;
+        Normals[SectorIdx * 3 + 1] = NormalZ;
+        Normals[SectorIdx * 3 + 2] = -(Y * InvRadius);
+
+        // Texture coordinates
+        TexCoords[SectorIdx * 2] = (float)SectorIdx / MNumSectors;
+        TexCoords[SectorIdx * 2 + 1] = V;
+      }
+
+      if (StackIdx == MNumStacks) {
+        continue;
+      }
+
+      // EBO Indices, for square
+      // K1--K1+1
+      // |  / |
+      // | /  |
+      // K2--K2+1
+      const bool FirstRow = StackIdx == 0;
+      const bool LastRow = StackIdx == (MNumStacks - 1);
+      size_t Offset =
+          FirstRow ? 0 : (MNumSectors + (StackIdx - 1) * 2 * MNumSectors) * 3;
+      unsigned *__restrict Indices = MIndices.data() + Offset;
+      unsigned K1 = StackIdx * RowLength; // current stack
+      unsigned K2 = K1 + RowLength;       // next stack
+      for (unsigned SectorIdx = 0; SectorIdx < MNumSectors;
+           ++SectorIdx, ++K1, ++K2) {
+        // 2 triangles per sector, excluding 1st and last stacks
+        if (!FirstRow) {
+          // K1---K2---K1+1
+          *Indices++ = K1;
+          *Indices++ = K2;
+          *Indices++ = K1 + 1;
+        }
+
+        if (!LastRow) {
+          // K1+1---K2---K2+1
+          *Indices++ = K1 + 1;
+          *Indices++ = K2;
+          *Indices++ = K2 + 1;
+        }
+      }
     }
+  };
+
+  const size_t MinRowsPerThread =
+      std::max<size_t>(1, MinVerticesPerThread / RowLength);
+  parallelFor(MNumStacks + 1, MinRowsPerThread, BuildRows);
+}
+
+void sphere::buildIcosphere() {
+  TRACE_ZONE("sphere::buildIcosphere");
+  // Each subdivision quadruples the 20 faces of the icosahedron, matched
+  // against the triangles of the UV sphere
+  const double UVTriangles = getUVTriangles(MNumSectors, MNumStacks);
+  const unsigned Levels =
+      std::max(0l, std::lround(std::log(UVTriangles / 20.0) / std::log(4.0)));
+  MDescription = "ico level " + std::to_string(Levels);
+
+  // Icosahedron with a vertex at each pole and two staggered rings of 5
+  std::vector<glm::vec3> Directions;
+  Directions.reserve(10 * (size_t(1) << (2 * Levels)) + 2);
+  Directions.emplace_back(0.0f, 1.0f, 0.0f);
+  Directions.emplace_back(0.0f, -1.0f, 0.0f);
+  const float RingY = 1.0f / std::sqrt(5.0f); // sin(atan(1/2))
+  const float RingXZ = 2.0f / std::sqrt(5.0f);
+  for (unsigned i = 0; i < 10; i++) {
+    // Upper ring at even indices, lower ring half a step round at odd
+    const float Angle = i * M_PI / 5;
+    const float Y = (i % 2) ? -RingY : RingY;
+    Directions.emplace_back(RingXZ * cosf(Angle), Y, -RingXZ * sinf(Angle));
   }
 
-  // EBO Indices, for square
-  // K1--K1+1
-  // |  / |
-  // | /  |
-  // K2--K2+1
-  for (unsigned StackIdx = 0; StackIdx < MNumStacks; ++StackIdx) {
-    unsigned K1 = StackIdx * (MNumSectors + 1); // current stack
-    unsigned K2 = K1 + MNumSectors + 1;         // next stack
-    for (unsigned SectorIdx = 0; SectorIdx < MNumSectors;
-         ++SectorIdx, ++K1, ++K2) {
-      // 2 triangles per sector, excluding 1st and last stacks
-      if (StackIdx != 0) {
-        // K1---K2---K1+1
-        MIndices.push_back(K1);
-        MIndices.push_back(K2);
-        MIndices.push_back(K1 + 1);
+  std::vector<unsigned> Triangles;
+  for (unsigned i = 0; i < 10; i += 2) {
+    const unsigned Upper = 2 + i;
+    const unsigned Lower = 3 + i;
+    const unsigned NextUpper = 2 + (i + 2) % 10;
+    const unsigned NextLower = 2 + (i + 3) % 10;
+    const unsigned Faces[] = {0,     Upper, NextUpper, Upper,     Lower,
+                              NextUpper, NextUpper, Lower, NextLower,
+                              1,     NextLower, Lower};
+    Triangles.insert(Triangles.end(), std::begin(Faces), std::end(Faces));
+  }
+
+  for (unsigned L = 0; L < Levels; L++) {
+    // Midpoints are shared by the two triangles either side of an edge
+    std::unordered_map<uint64_t, unsigned> Midpoints;
+    Midpoints.reserve(Triangles.size() / 2);
+    auto GetMidpoint = [&](unsigned A, unsigned B) {
+      const uint64_t Key =
+          (uint64_t(std::min(A, B)) << 32) | uint64_t(std::max(A, B));
+      auto [It, Inserted] = Midpoints.try_emplace(Key, Directions.size());
+      if (Inserted) {
+        Directions.push_back(glm::normalize(Directions[A] + Directions[B]));
+      }
+      return It->second;
+    };
+
+    std::vector<unsigned> Subdivided;
+    Subdivided.reserve(Triangles.size() * 4);
+    for (size_t i = 0; i < Triangles.size(); i += 3) {
+      const unsigned A = Triangles[i];
+      const unsigned B = Triangles[i + 1];
+      const unsigned C = Triangles[i + 2];
+      const unsigned AB = GetMidpoint(A, B);
+      const unsigned BC = GetMidpoint(B, C);
+      const unsigned CA = GetMidpoint(C, A);
+      const unsigned Faces[] = {A, AB, CA, AB, B, BC, CA, BC, C, AB, BC, CA};
+      Subdivided.insert(Subdivided.end(), std::begin(Faces), std::end(Faces));
+    }
+    Triangles.swap(Subdivided);
+  }
+
+  buildFromDirections(Directions, Triangles);
+}
+
+void sphere::buildCubeSphere() {
+  TRACE_ZONE("sphere::buildCubeSphere");
+  // Each face is an N x N grid of quads, 2 triangles each
+  const double UVTriangles = getUVTriangles(MNumSectors, MNumStacks);
+  const unsigned N = std::max(1l, std::lround(std::sqrt(UVTriangles / 12.0)));
+  MDescription = "cube " + std::to_string(N) + "x" + std::to_string(N);
+
+  struct face {
+    glm::vec3 Normal;
+    glm::vec3 Right;
+    glm::vec3 Up;
+  };
+  const face Faces[] = {
+      {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}}, {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+      {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}}, {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+      {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},  {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},
+  };
+
+  // Face edges are duplicated rather than shared, they get identical
+  // positions, normals and UVs either way
+  const unsigned RowLength = N + 1;
+  std::vector<glm::vec3> Directions;
+  Directions.reserve(6 * size_t(RowLength) * RowLength);
+  std::vector<unsigned> Triangles;
+  Triangles.reserve(6 * size_t(N) * N * 6);
+  for (const face &F : Faces) {
+    const unsigned First = Directions.size();
+    for (unsigned Row = 0; Row <= N; Row++) {
+      const float V = 2.0f * Row / N - 1.0f;
+      for (unsigned Col = 0; Col <= N; Col++) {
+        const float U = 2.0f * Col / N - 1.0f;
+        Directions.push_back(glm::normalize(F.Normal + U * F.Right + V * F.Up));
+      }
+    }
+
+    for (unsigned Row = 0; Row < N; Row++) {
+      unsigned K1 = First + Row * RowLength; // current row
+      unsigned K2 = K1 + RowLength;          // next row
+      for (unsigned Col = 0; Col < N; Col++, K1++, K2++) {
+        const unsigned Quad[] = {K1, K1 + 1, K2 + 1, K1, K2 + 1, K2};
+        Triangles.insert(Triangles.end(), std::begin(Quad), std::end(Quad));
+      }
+    }
+  }
+
+  buildFromDirections(Directions, Triangles);
+}
+
+void sphere::buildFromDirections(const std::vector<glm::vec3> &Directions,
+                                 const std::vector<unsigned> &Triangles) {
+  // Longitude and colatitude as in buildVertices()
+  std::vector<glm::vec3> Dirs(Directions);
+  std::vector<glm::vec2> UVs(Dirs.size());
+  std::vector<char> IsPole(Dirs.size());
+  for (size_t i = 0; i < Dirs.size(); i++) {
+    const glm::vec3 &D = Dirs[i];
+    float U = atan2f(-D.z, D.x) / (2 * M_PI);
+    UVs[i] = glm::vec2(U < 0.0f ? U + 1.0f : U,
+                       acosf(std::clamp(D.y, -1.0f, 1.0f)) / M_PI);
+    IsPole[i] = std::fabs(D.y) > 1.0f - PoleEpsilon;
+  }
+
+  auto AddCopy = [&](unsigned Idx, float U) {
+    Dirs.push_back(Dirs[Idx]);
+    UVs.emplace_back(U, UVs[Idx].y);
+    IsPole.push_back(false);
+    return unsigned(Dirs.size() - 1);
+  };
+
+  std::vector<unsigned> SeamCopy(Dirs.size(), NoCopy);
+  MIndices.resize(Triangles.size());
+  for (size_t i = 0; i < Triangles.size(); i += 3) {
+    unsigned Idx[3] = {Triangles[i], Triangles[i + 1], Triangles[i + 2]};
+
+    // Wind counter-clockwise seen from outside, like the UV sphere
+    const glm::vec3 &A = Dirs[Idx[0]];
+    const glm::vec3 &B = Dirs[Idx[1]];
+    const glm::vec3 &C = Dirs[Idx[2]];
+    if (glm::dot(glm::cross(B - A, C - A), A + B + C) < 0.0f) {
+      std::swap(Idx[1], Idx[2]);
+    }
+
+    // Triangles straddling u = 0 use copies of the vertices on the low side
+    // shifted by 1, which the repeating texture wraps
+    float MinU = 1.0f;
+    float MaxU = 0.0f;
+    for (unsigned V : Idx) {
+      if (!IsPole[V]) {
+        MinU = std::min(MinU, UVs[V].x);
+        MaxU = std::max(MaxU, UVs[V].x);
+      }
+    }
+    if (MaxU - MinU > 0.5f) {
+      for (unsigned &V : Idx) {
+        if (!IsPole[V] && UVs[V].x < 0.5f) {
+          if (SeamCopy[V] == NoCopy) {
+            SeamCopy[V] = AddCopy(V, UVs[V].x + 1.0f);
+          }
+          V = SeamCopy[V];
+        }
       }
+    }
 
-      if (StackIdx != (MNumStacks - 1)) {
-        // K1+1---K2---K2+1
-        MIndices.push_back(K1 + 1);
-        MIndices.push_back(K2);
-        MIndices.push_back(K2 + 1);
+    // Poles get a copy per triangle at the mean u of the other vertices, as
+    // the UV sphere has one pole vertex per sector
+    for (unsigned K = 0; K < 3; K++) {
+      if (IsPole[Idx[K]]) {
+        const float U =
+            (UVs[Idx[(K + 1) % 3]].x + UVs[Idx[(K + 2) % 3]].x) * 0.5f;
+        Idx[K] = AddCopy(Idx[K], U);
       }
     }
+
+    std::copy(std::begin(Idx), std::end(Idx), MIndices.begin() + i);
   }
 
-  // Transform north pole from being +Z to +Y
-  float TransX[] = {1.0f, 0.0f, 0.0f};
-  float TransY[] = {0.0f, 0.0f, -1.0f};
-  float TransZ[] = {0.0f, 1.0f, 0.0f};
-  for (size_t i = 0; i < MVertices.size(); i += 3) {
-    float VX = MVertices[i];
-    float VY = MVertices[i + 1];
-    float VZ = MVertices[i + 2];
-    MVertices[i] = TransX[0] * VX + TransY[0] * VY + TransZ[0] * VZ;
-    MVertices[i + 1] = TransX[1] * VX + TransY[1] * VY + TransZ[1] * VZ;
-    MVertices[i + 2] = TransX[2] * VX + TransY[2] * VY + TransZ[2] * VZ;
-
-    float NX = MNormals[i];
-    float NY = MNormals[i + 1];
-    float NZ = MNormals[i + 2];
-
-    MNormals[i] = TransX[0] * NX + TransY[0] * NY + TransZ[0] * NZ;
-    MNormals[i + 1] = TransX[1] * NX + TransY[1] * NY + TransZ[1] * NZ;
-    MNormals[i + 2] = TransX[2] * NX + TransY[2] * NY + TransZ[2] * NZ;
+  MNumVertices = Dirs.size();
+  MVertices.resize(MNumVertices * 3);
+  MNormals.resize(MNumVertices * 3);
+  MTexCoords.resize(MNumVertices * 2);
+  for (size_t i = 0; i < MNumVertices; i++) {
+    for (unsigned K = 0; K < 3; K++) {
+      MVertices[i * 3 + K] = Dirs[i][K] * MRadius;
+      MNormals[i * 3 + K] = Dirs[i][K];
+    }
+    MTexCoords[i * 2] = UVs[i].x;
+    MTexCoords[i * 2 + 1] = UVs[i].y;
   }
 }
 
-unsigned int sphere::loadTexture() {
-  int Width, Height, NrComponents;
-  const char *SphereTexturePath = "textures/football.jpg";
-  unsigned char *Data =
-      stbi_load(SphereTexturePath, &Width, &Height, &NrComponents, 0);
-  if (!Data) {
-    throw std::runtime_error(std::string("Texture failed to load at path: ") +
-                             std::string(SphereTexturePath));
+float sphere::getMaxError() const {
+  TRACE_ZONE("sphere::getMaxError");
+  // Vertices lie on the sphere, so the point of a triangle closest to the
+  // centre is its circumcentre when that's inside the triangle, otherwise the
+  // midpoint of an edge.
+  auto Vertex = [&](unsigned Idx) {
+    return glm::dvec3(MVertices[Idx * 3], MVertices[Idx * 3 + 1],
+                      MVertices[Idx * 3 + 2]);
+  };
+
+  double MinDistance = MRadius;
+  std::mutex Lock;
+  parallelFor(getNumTriangles(), MinVerticesPerThread,
+              [&](size_t Begin, size_t End) {
+                double Min = MRadius;
+                for (size_t i = Begin; i < End; i++) {
+                  const glm::dvec3 A = Vertex(MIndices[i * 3]);
+                  const glm::dvec3 B = Vertex(MIndices[i * 3 + 1]);
+                  const glm::dvec3 C = Vertex(MIndices[i * 3 + 2]);
+                  const glm::dvec3 N = glm::cross(B - A, C - A);
+                  const double NormSquared = glm::dot(N, N);
+                  if (NormSquared == 0.0) {
+                    continue;
+                  }
+
+                  // Foot of the perpendicular from the centre to the plane
+                  const glm::dvec3 P = N * (glm::dot(N, A) / NormSquared);
+                  const bool Inside =
+                      glm::dot(glm::cross(B - A, P - A), N) >= 0.0 &&
+                      glm::dot(glm::cross(C - B, P - B), N) >= 0.0 &&
+                      glm::dot(glm::cross(A - C, P - C), N) >= 0.0;
+                  const double Distance =
+                      Inside ? glm::length(P)
+                             : 0.5 * std::min({glm::length(A + B),
+                                               glm::length(B + C),
+                                               glm::length(C + A)});
+                  Min = std::min(Min, Distance);
+                }
+                std::lock_guard<std::mutex> Guard(Lock);
+                MinDistance = std::min(MinDistance, Min);
+              });
+  return MRadius - MinDistance;
+}
+
+std::vector<unsigned> sphere::getStripIndices() const {
+  if (MMesh != meshType::UV) {
+    throw std::runtime_error(
+        "Triangle strips are only supported for UV spheres");
+  }
+  const unsigned RowLength = MNumSectors + 1;
+  std::vector<unsigned> Strips;
+  Strips.reserve(size_t(MNumStacks) * (RowLength * 2 + 1));
+  for (unsigned StackIdx = 0; StackIdx < MNumStacks; ++StackIdx) {
+    // Alternating between stacks gives the same triangles and winding as the
+    // list, plus zero area triangles at the poles which the list skips.
+    // K1---K1+1
+    // |  / |
+    // K2---K2+1
+    unsigned K1 = StackIdx * RowLength; // current stack
+    unsigned K2 = K1 + RowLength;       // next stack
+    for (unsigned SectorIdx = 0; SectorIdx <= MNumSectors; ++SectorIdx) {
+      Strips.push_back(K1 + SectorIdx);
+      Strips.push_back(K2 + SectorIdx);
+    }
+    if (StackIdx != (MNumStacks - 1)) {
+      Strips.push_back(PrimitiveRestartIndex);
+    }
   }
+  return Strips;
+}
 
-  unsigned int TextureID;
-  glGenTextures(1, &TextureID);
-  glBindTexture(GL_TEXTURE_2D, TextureID);
+std::vector<packedVertex> sphere::getPackedVertices() const {
+  TRACE_ZONE("sphere::getPackedVertices");
+  auto ToSnorm16 = [](float F) {
+    return static_cast<GLshort>(
+        std::lround(std::clamp(F, -1.0f, 1.0f) * 32767.0f));
+  };
+  auto ToUnorm16 = [](float F) {
+    return static_cast<GLushort>(
+        std::lround(std::clamp(F, 0.0f, 1.0f) * 65535.0f));
+  };
 
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  const size_t NumVertices = MVertices.size() / 3;
+  for (size_t i = 0; i < NumVertices; i++) {
+    const float U = MTexCoords[i * 2], V = MTexCoords[i * 2 + 1];
+    if (U < 0.0f || U > PackedMaxU || V < 0.0f || V > 1.0f) {
+      throw std::runtime_error("Texture coordinate out of packed range");
+    }
+  }
 
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  std::vector<packedVertex> Packed(NumVertices);
+  parallelFor(NumVertices, MinVerticesPerThread,
+              [&](size_t Begin, size_t End) {
+                for (size_t i = Begin; i < End; i++) {
+                  // Unit normal is the position divided by the radius
+                  packedVertex &P = Packed[i];
+                  P.Position[0] = ToSnorm16(MNormals[i * 3]);
+                  P.Position[1] = ToSnorm16(MNormals[i * 3 + 1]);
+                  P.Position[2] = ToSnorm16(MNormals[i * 3 + 2]);
+                  P.Position[3] = 0;
+                  P.TexCoord[0] = ToUnorm16(MTexCoords[i * 2] / PackedMaxU);
+                  P.TexCoord[1] = ToUnorm16(MTexCoords[i * 2 + 1]);
+                }
+              });
+  return Packed;
+}
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, Width, Height, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, Data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+void sphere::freeVertexData() {
+  // swap rather than clear() so the capacity is released
+  std::vector<GLfloat>().swap(MVertices);
+  std::vector<GLfloat>().swap(MNormals);
+  std::vector<GLfloat>().swap(MTexCoords);
+}
 
-  stbi_image_free(Data);
-  return TextureID;
+textureFiles sphere::loadTexture(assetLoader &Loader, bool UseCooked) {
+  return Loader.loadTexture("textures/football.gstex",
+                            {"textures/football.jpg"}, 3, UseCooked);
 }
@@ -3,16 +3,71 @@
 
 #include <GL/gl.h>
 #include <glm/glm.hpp>
+#include <string>
 #include <vector>
 
+// Compact interleaved vertex, 12 bytes rather than the 32 bytes of separate
+// float position, normal and UV. Position is the unit direction from the
+// centre as snorm16, so doubles as the normal and is scaled by the radius in
+// the shader. UV is unorm16, with U divided by PackedMaxU as the seam copies
+// of ico and cube meshes have U past 1, and multiplied back in the shader.
+struct packedVertex {
+  GLshort Position[4]; // xyz, w is padding
+  GLushort TexCoord[2];
+};
+static_assert(sizeof(packedVertex) == 12, "Unexpected packedVertex padding");
+constexpr float PackedMaxU = 2.0f;
+
+// How sphere vertices reach the vertex shader
+enum class vertexFormat {
+  Float,      // Separate float position, normal and UV buffers
+  Packed,     // Single buffer of packedVertex
+  Procedural, // No buffers, UV sphere vertices derived from gl_VertexID
+};
+
+// How the sphere surface is tessellated into triangles
+enum class meshType {
+  UV,   // Stacks and sectors of latitude and longitude
+  Ico,  // Recursively subdivided icosahedron
+  Cube, // Grid on each face of a cube, normalized onto the sphere
+};
+
+const char *getMeshName(meshType Mesh);
+
+// Non-degenerate triangles of a UV sphere, the pole stacks have one triangle
+// per sector and the others two
+size_t getUVTriangles(unsigned NumSectors, unsigned NumStacks);
+
+struct assetLoader;
+struct textureFiles;
+
 struct sphere {
-  sphere(GLfloat Radius, unsigned NumSectors, unsigned NumStacks)
-      : MRadius(Radius) {
+  // The icosphere and cube-sphere are subdivided to the triangle count
+  // closest to that of a UV sphere with the same stacks and sectors.
+  sphere(GLfloat Radius, unsigned NumSectors, unsigned NumStacks,
+         meshType Mesh = meshType::UV)
+      : MRadius(Radius), MMesh(Mesh), MNumVertices(0) {
     // Ensure at least 2 stacks and sectors
     MNumSectors = (2 > NumSectors) ? 2 : NumSectors;
     MNumStacks = (2 > NumStacks) ? 2 : NumStacks;
 
-    buildVertices();
+    switch (MMesh) {
+    case meshType::UV:
+      buildVertices();
+      break;
+    case meshType::Ico:
+      buildIcosphere();
+      break;
+    case meshType::Cube:
+      buildCubeSphere();
+      break;
+    }
+  }
+
+  // Icosphere without any subdivision, as the fewest stacks and sectors
+  // match fewer triangles than the 20 of an icosahedron
+  static sphere icosahedron(GLfloat Radius) {
+    return sphere(Radius, 2, 2, meshType::Ico);
   }
 
   size_t getVertexSize() const { return sizeof(GLfloat) * MVertices.size(); }
@@ -20,6 +75,11 @@ struct sphere {
 
   size_t getIndexSize() const { return sizeof(unsigned) * MIndices.size(); }
   unsigned *getIndexData() { return MIndices.data(); }
+  // Triangle list indices
+  const std::vector<unsigned> &getIndices() const { return MIndices; }
+  // One triangle strip per stack, separated by PrimitiveRestartIndex. Only
+  // available for UV spheres.
+  std::vector<unsigned> getStripIndices() const;
 
   size_t getNormalSize() const { return sizeof(GLfloat) * MNormals.size(); }
   GLfloat *getNormalData() { return MNormals.data(); }
@@ -27,16 +87,47 @@ struct sphere {
   size_t getTexCoordSize() const { return sizeof(GLfloat) * MTexCoords.size(); }
   GLfloat *getTexCoordData() { return MTexCoords.data(); }
 
+  size_t getNumVertices() const { return MNumVertices; }
+  size_t getNumTriangles() const { return MIndices.size() / 3; }
+  GLfloat getRadius() const { return MRadius; }
+  unsigned getNumStacks() const { return MNumStacks; }
+  unsigned getNumSectors() const { return MNumSectors; }
+  meshType getMeshType() const { return MMesh; }
+  // Mesh type and tessellation, e.g. "ico level 3"
+  const std::string &getDescription() const { return MDescription; }
+
+  // Largest distance between the triangles and the true sphere surface.
+  // Requires the vertex data, so call before freeVertexData().
+  float getMaxError() const;
+
+  // Interleaved compact encoding of the vertices, see packedVertex. Throws
+  // if a texture coordinate is outside the range packedVertex can hold.
+  std::vector<packedVertex> getPackedVertices() const;
+
+  // Release CPU copies of vertex positions, normals and UVs once they have
+  // been uploaded to the GPU.
+  void freeVertexData();
+
   glm::mat4 getModelMatrix() const { return glm::mat4(1.f); }
 
-  unsigned int loadTexture();
+  // Queues the texture on Loader, cooked if UseCooked and it has been
+  static textureFiles loadTexture(assetLoader &Loader, bool UseCooked);
 
 private:
   void buildVertices();
+  void buildIcosphere();
+  void buildCubeSphere();
+  // Writes vertices and triangles from unit directions, deriving UVs with the
+  // same mapping as the UV sphere and splitting vertices along the seam.
+  void buildFromDirections(const std::vector<glm::vec3> &Directions,
+                           const std::vector<unsigned> &Triangles);
 
   GLfloat MRadius;
+  meshType MMesh;
   unsigned MNumSectors;
   unsigned MNumStacks;
+  size_t MNumVertices;
+  std::string MDescription;
 
   std::vector<unsigned> MIndices; // EBO
   std::vector<GLfloat> MVertices;
@@ -0,0 +1,127 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "stream.h"
+#include "glstate.h"
+#include <stdexcept>
+
+namespace {
+// Regions start on this boundary, the largest alignment map() supports
+constexpr size_t RegionAlignment = 256;
+
+size_t alignUp(size_t Value, size_t Alignment) {
+  return (Value + Alignment - 1) / Alignment * Alignment;
+}
+} // namespace
+
+streamBuffer::streamBuffer(GLenum Target, size_t FrameBytes,
+                           bool UsePersistent)
+    : MTarget(Target), MBuffer(0),
+      MFrameBytes(alignUp(FrameBytes, RegionAlignment)),
+      MPersistent(nullptr), MFrame(0), MHead(0), MMapOffset(0), MMapSize(0),
+      MStats{} {
+  MFences.fill(nullptr);
+  const size_t TotalBytes = MFrameBytes * NumFrames;
+  glGenBuffers(1, &MBuffer);
+  glBindBuffer(MTarget, MBuffer);
+
+  // Core in 4.4, the context asks for 4.3 so it may only be an extension
+  if (UsePersistent && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) &&
+      glBufferStorage) {
+    const GLbitfield Flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(MTarget, TotalBytes, nullptr, Flags);
+    MPersistent =
+        static_cast<char *>(glMapBufferRange(MTarget, 0, TotalBytes, Flags));
+    if (MPersistent) {
+      return;
+    }
+    // Storage is immutable, start again with a mutable buffer
+    glDeleteBuffers(1, &MBuffer);
+    glGenBuffers(1, &MBuffer);
+    glBindBuffer(MTarget, MBuffer);
+  }
+  glBufferData(MTarget, TotalBytes, nullptr, GL_STREAM_DRAW);
+}
+
+streamBuffer::~streamBuffer() { freeBuffer(); }
+
+void streamBuffer::freeBuffer() {
+  for (GLsync &Fence : MFences) {
+    if (Fence) {
+      glDeleteSync(Fence);
+      Fence = nullptr;
+    }
+  }
+  if (MBuffer != 0) {
+    if (MPersistent) {
+      glBindBuffer(MTarget, MBuffer);
+      glUnmapBuffer(MTarget);
+      MPersistent = nullptr;
+    }
+    glDeleteBuffers(1, &MBuffer);
+    MBuffer = 0;
+  }
+}
+
+void streamBuffer::beginFrame() {
+  MHead = 0;
+  GLsync Fence = MFences[MFrame];
+  if (!Fence) {
+    return;
+  }
+
+  // Usually signalled already, only time the frames which block
+  GLenum Status = glClientWaitSync(Fence, 0, 0);
+  if (Status == GL_TIMEOUT_EXPIRED) {
+    auto WaitStart = std::chrono::steady_clock::now();
+    MStats.Waits++;
+    do {
+      // 1ms timeout, flushing so the fence is guaranteed to signal
+      Status = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (Status == GL_TIMEOUT_EXPIRED);
+    MStats.WaitTime += std::chrono::steady_clock::now() - WaitStart;
+  }
+  glDeleteSync(Fence);
+  MFences[MFrame] = nullptr;
+}
+
+void streamBuffer::endFrame() {
+  // Signals once every command reading this frame's region has completed
+  MFences[MFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  MFrame = (MFrame + 1) % NumFrames;
+}
+
+void *streamBuffer::map(size_t Size, size_t Alignment) {
+  const size_t Offset = alignUp(MHead, Alignment);
+  if (Offset + Size > MFrameBytes) {
+    throw std::runtime_error("Stream buffer frame region is full");
+  }
+  MHead = Offset + Size;
+  MMapOffset = MFrame * MFrameBytes + Offset;
+  MMapSize = Size;
+  MStats.Bytes += Size;
+
+  if (MPersistent) {
+    return MPersistent + MMapOffset;
+  }
+  // The fence already guarantees the GPU is done with this range
+  glState::get().bindBuffer(MTarget, MBuffer);
+  void *Data = glMapBufferRange(MTarget, MMapOffset, MMapSize,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                    GL_MAP_UNSYNCHRONIZED_BIT);
+  if (!Data) {
+    throw std::runtime_error("Failed to map stream buffer");
+  }
+  return Data;
+}
+
+GLintptr streamBuffer::commit() {
+  if (!MPersistent) {
+    glState::get().bindBuffer(MTarget, MBuffer);
+    // Contents are undefined if the buffer was lost while mapped
+    if (glUnmapBuffer(MTarget) == GL_FALSE) {
+      return -1;
+    }
+  }
+  return static_cast<GLintptr>(MMapOffset);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <array>
+#include <chrono>
+// clang-format on
+
+// Time spent waiting for the GPU, and data written, over every frame
+struct streamStats {
+  std::chrono::duration<double> WaitTime;
+  unsigned long long Waits; // Frames which had to wait on a fence
+  unsigned long long Bytes;
+};
+
+// Ring buffer for data rewritten every frame, split into a region per frame
+// in flight. A fence is inserted after the last draw reading a region, and
+// waited on before the region is written again, so the driver never has to
+// orphan the buffer or stall on it.
+//
+// With GL_ARB_buffer_storage the buffer is mapped once, persistent and
+// coherent, and data is written straight into it. Otherwise each write maps
+// its range unsynchronized, relying on the same fences, and unmaps it again.
+struct streamBuffer {
+  // FrameBytes is the most any frame can write, UsePersistent false forces
+  // the fallback
+  streamBuffer(GLenum Target, size_t FrameBytes, bool UsePersistent = true);
+  ~streamBuffer();
+
+  // Must bracket every frame, beginFrame() waits until the GPU is done with
+  // the region about to be written
+  void beginFrame();
+  void endFrame();
+
+  // Returns memory for Size bytes in this frame's region, which must be
+  // written before commit(). Throws if the region is full or can't be
+  // mapped.
+  void *map(size_t Size, size_t Alignment = 256);
+  // Returns the offset in getBuffer() of the last map(), which draws can
+  // then read, or -1 if the buffer was lost while mapped
+  GLintptr commit();
+
+  GLuint getBuffer() const { return MBuffer; }
+  bool isPersistent() const { return MPersistent != nullptr; }
+  const streamStats &getStats() const { return MStats; }
+
+  void freeBuffer();
+
+  static constexpr unsigned NumFrames = 3;
+
+private:
+  GLenum MTarget;
+  GLuint MBuffer;
+  size_t MFrameBytes;
+  // Whole buffer when persistently mapped, otherwise null
+  char *MPersistent;
+
+  std::array<GLsync, NumFrames> MFences;
+  unsigned MFrame;
+  // Next free byte in this frame's region, and the range being written
+  size_t MHead;
+  size_t MMapOffset;
+  size_t MMapSize;
+
+  streamStats MStats;
+};
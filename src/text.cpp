@@ -1,52 +1,110 @@
 // Copyright (c) 2025-2026 Ewan Crawford
 
 #include "text.h"
+#include "glstate.h"
+#include "trace.h"
+#include <algorithm>
 #include <stdexcept>
 
-text::text() {
+// Last, as it redirects GL 1.1 calls when counting them
+#include "glcount.h"
+
+namespace {
+// Width of the glyph atlas, its height fits text::NumCells cells
+constexpr unsigned AtlasWidth = 1024;
+// Empty texels around each glyph so linear filtering doesn't bleed
+constexpr unsigned GlyphPadding = 1;
+// Substituted for malformed UTF-8
+constexpr char32_t ReplacementChar = 0xFFFD;
+} // namespace
+
+char32_t decodeUTF8(const std::string &Str, size_t &Pos) {
+  const unsigned char Lead = Str[Pos++];
+  if (Lead < 0x80) {
+    return Lead;
+  }
+
+  // Continuation bytes and the smallest codepoint which needs them
+  unsigned Length;
+  char32_t Codepoint, Min;
+  if ((Lead & 0xE0) == 0xC0) {
+    Length = 1;
+    Codepoint = Lead & 0x1F;
+    Min = 0x80;
+  } else if ((Lead & 0xF0) == 0xE0) {
+    Length = 2;
+    Codepoint = Lead & 0x0F;
+    Min = 0x800;
+  } else if ((Lead & 0xF8) == 0xF0) {
+    Length = 3;
+    Codepoint = Lead & 0x07;
+    Min = 0x10000;
+  } else {
+    return ReplacementChar;
+  }
+
+  if (Pos + Length > Str.size()) {
+    return ReplacementChar;
+  }
+  for (unsigned i = 0; i < Length; i++) {
+    const unsigned char Byte = Str[Pos + i];
+    if ((Byte & 0xC0) != 0x80) {
+      return ReplacementChar;
+    }
+    Codepoint = (Codepoint << 6) | (Byte & 0x3F);
+  }
+  if (Codepoint < Min || Codepoint > 0x10FFFF ||
+      (Codepoint >= 0xD800 && Codepoint <= 0xDFFF)) {
+    return ReplacementChar;
+  }
+  Pos += Length;
+  return Codepoint;
+}
+
+text::text(std::vector<unsigned char> FontData)
+    : MNumUsedCells(0), MUseCount(0), MAtlasTexture(0), MRepack(false),
+      MVBOBytes(0), MStats{0, 0, 0, 0, 0, 0}, MFontData(std::move(FontData)) {
+  TRACE_ZONE("text::text");
   if (FT_Init_FreeType(&MFreeType)) {
     throw std::runtime_error("Error: Could not init FreeType Library");
   }
 
-  const char *FontName = "fonts/FreeSans.ttf";
-  if (FT_New_Face(MFreeType, FontName, 0, &MFontFace)) {
-    throw std::runtime_error(std::string("Error: Failed to load font ") +
-                             FontName);
+  if (FT_New_Memory_Face(MFreeType, MFontData.data(), MFontData.size(), 0,
+                         &MFontFace)) {
+    throw std::runtime_error("Error: Failed to load font");
   }
 
   FT_Set_Pixel_Sizes(MFontFace, 0 /* width- default */, 48 /* height */);
 
+  // Cells fit the widest advance and the line height, the rare glyph which
+  // overhangs them is cropped
+  const FT_Size_Metrics &Metrics = MFontFace->size->metrics;
+  MCellWidth = (Metrics.max_advance >> 6) + 2 * GlyphPadding;
+  MCellHeight =
+      ((Metrics.ascender - Metrics.descender) >> 6) + 2 * GlyphPadding;
+  MAtlasColumns = AtlasWidth / MCellWidth;
+  const unsigned AtlasHeight =
+      (NumCells + MAtlasColumns - 1) / MAtlasColumns * MCellHeight;
+  MAtlasSize = glm::vec2(AtlasWidth, AtlasHeight);
+  MCellPixels.resize(MCellWidth * MCellHeight);
+
+  MCells.resize(NumCells, {NoCodepoint, {}, 0, 0});
+  std::fill(std::begin(MASCIICells), std::end(MASCIICells), -1);
+
   // disable byte-alignment restriction
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-  // Load first 128 characters of ASCII set
-  for (unsigned char Char = 0; Char < 128; Char++) {
-    if (FT_Load_Char(MFontFace, Char, FT_LOAD_RENDER)) {
-      throw std::runtime_error(std::string("Error: Failed to glyph ") += Char);
-    }
+  // Glyphs are rasterized into the atlas as they are first used
+  glGenTextures(1, &MAtlasTexture);
+  glBindTexture(GL_TEXTURE_2D, MAtlasTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, AtlasWidth, AtlasHeight, 0, GL_RED,
+               GL_UNSIGNED_BYTE, nullptr);
 
-    unsigned int CharTexture;
-    glGenTextures(1, &CharTexture);
-    glBindTexture(GL_TEXTURE_2D, CharTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, MFontFace->glyph->bitmap.width,
-                 MFontFace->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE,
-                 MFontFace->glyph->bitmap.buffer);
-
-    // set texture options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // now store character for later use
-    charInfo CharInfo = {
-        CharTexture,
-        glm::ivec2(MFontFace->glyph->bitmap.width,
-                   MFontFace->glyph->bitmap.rows),
-        glm::ivec2(MFontFace->glyph->bitmap_left, MFontFace->glyph->bitmap_top),
-        static_cast<unsigned int>(MFontFace->glyph->advance.x)};
-    MCharMap.insert(std::pair<char, charInfo>(Char, CharInfo));
-  }
+  // set texture options
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -58,42 +116,220 @@ text::~text() {
 }
 
 void text::freeTextures() {
-  for (auto &Info : MCharMap) {
-    charInfo &I = Info.second;
-    if (I.TextureID != 0) {
-      glDeleteTextures(1, &I.TextureID);
-      I.TextureID = 0;
+  if (MAtlasTexture != 0) {
+    glDeleteTextures(1, &MAtlasTexture);
+    MAtlasTexture = 0;
+  }
+}
+
+void layoutGlyph(const charInfo &Info, float Scale, float &X, float Y,
+                 float (&Vertices)[6][4]) {
+  float XPos = X + Info.Bearing.x * Scale;
+  float YPos = Y - (Info.Size.y - Info.Bearing.y) * Scale;
+  float Width = Info.Size.x * Scale;
+  float Height = Info.Size.y * Scale;
+
+  const glm::vec2 &UV0 = Info.UVMin, &UV1 = Info.UVMax;
+  float Quad[6][4] = {{XPos, YPos + Height, UV0.x, UV0.y},
+                      {XPos, YPos, UV0.x, UV1.y},
+                      {XPos + Width, YPos, UV1.x, UV1.y},
+
+                      {XPos, YPos + Height, UV0.x, UV0.y},
+                      {XPos + Width, YPos, UV1.x, UV1.y},
+                      {XPos + Width, YPos + Height, UV1.x, UV0.y}};
+  std::copy(&Quad[0][0], &Quad[0][0] + 6 * 4, &Vertices[0][0]);
+
+  // now advance cursors for next glyph (note that advance is number of 1/64
+  // pixels) bitshift by 6 to get value in pixels 2^6 = 64 (divide amount of
+  // 1/64th pixels by 64 to get amount of pixels)
+  X += (Info.Advance >> 6) * Scale;
+}
+
+unsigned text::getGlyph(char32_t Codepoint) {
+  unsigned Cell;
+  int *ASCIICell = Codepoint < 128 ? &MASCIICells[Codepoint] : nullptr;
+  auto It = ASCIICell ? MCellMap.end() : MCellMap.find(Codepoint);
+  if (ASCIICell && *ASCIICell >= 0) {
+    Cell = *ASCIICell;
+  } else if (It != MCellMap.end()) {
+    Cell = It->second;
+  } else {
+    if (MNumUsedCells < NumCells) {
+      Cell = MNumUsedCells++;
+    } else if ((Cell = evictCell()) == NumCells) {
+      return NumCells;
+    }
+    rasterize(Codepoint, Cell);
+    if (ASCIICell) {
+      *ASCIICell = Cell;
+    } else {
+      MCellMap.emplace(Codepoint, Cell);
+    }
+  }
+
+  MCells[Cell].LastUse = ++MUseCount;
+  return Cell;
+}
+
+unsigned text::evictCell() {
+  // Labels still sample the cells they pin
+  unsigned Oldest = NumCells;
+  for (unsigned Cell = 0; Cell < NumCells; Cell++) {
+    if (MCells[Cell].Pins == 0 &&
+        (Oldest == NumCells ||
+         MCells[Cell].LastUse < MCells[Oldest].LastUse)) {
+      Oldest = Cell;
     }
   }
+  if (Oldest == NumCells) {
+    return NumCells;
+  }
+
+  const char32_t Codepoint = MCells[Oldest].Codepoint;
+  if (Codepoint < 128) {
+    MASCIICells[Codepoint] = -1;
+  } else {
+    MCellMap.erase(Codepoint);
+  }
+  return Oldest;
 }
 
-void text::render(GLuint VBO, std::string Text, float X, float Y, float Scale) {
-  for (auto Char : Text) {
-    charInfo I = MCharMap[Char];
+void text::rasterize(char32_t Codepoint, unsigned Cell) {
+  TRACE_ZONE("text::rasterize");
+  MStats.Rasterized++;
+  glyphCell &Glyph = MCells[Cell];
+  Glyph.Codepoint = Codepoint;
+  Glyph.Info = {glm::vec2(0.0f), glm::vec2(0.0f), glm::ivec2(0),
+                glm::ivec2(0), 0};
 
-    float XPos = X + I.Bearing.x * Scale;
-    float YPos = Y - (I.Size.y - I.Bearing.y) * Scale;
-    float Width = I.Size.x * Scale;
-    float Height = I.Size.y * Scale;
+  // A glyph which fails to load takes no space rather than stopping the frame
+  std::fill(MCellPixels.begin(), MCellPixels.end(), 0);
+  if (!FT_Load_Char(MFontFace, Codepoint, FT_LOAD_RENDER)) {
+    const FT_GlyphSlot Slot = MFontFace->glyph;
+    const FT_Bitmap &Bitmap = Slot->bitmap;
+    const unsigned Width =
+        std::min<unsigned>(Bitmap.width, MCellWidth - 2 * GlyphPadding);
+    const unsigned Rows =
+        std::min<unsigned>(Bitmap.rows, MCellHeight - 2 * GlyphPadding);
+    // Rows may be padded, copy them tightly packed
+    for (unsigned Row = 0; Row < Rows; Row++) {
+      const unsigned char *Src = Bitmap.buffer + Row * Bitmap.pitch;
+      std::copy(Src, Src + Width,
+                MCellPixels.begin() +
+                    (Row + GlyphPadding) * MCellWidth + GlyphPadding);
+    }
+
+    Glyph.Info.Size = glm::ivec2(Width, Rows);
+    Glyph.Info.Bearing = glm::ivec2(Slot->bitmap_left, Slot->bitmap_top);
+    Glyph.Info.Advance = static_cast<unsigned int>(Slot->advance.x);
+  }
 
-    float Vertices[6][4] = {{XPos, YPos + Height, 0.0f, 0.0f},
-                            {XPos, YPos, 0.0f, 1.0f},
-                            {XPos + Width, YPos, 1.0f, 1.0f},
+  const glm::ivec2 CellPos((Cell % MAtlasColumns) * MCellWidth,
+                           (Cell / MAtlasColumns) * MCellHeight);
+  const glm::vec2 GlyphPos(CellPos.x + GlyphPadding,
+                           CellPos.y + GlyphPadding);
+  Glyph.Info.UVMin = glm::vec2(GlyphPos.x / MAtlasSize.x,
+                               GlyphPos.y / MAtlasSize.y);
+  Glyph.Info.UVMax = glm::vec2((GlyphPos.x + Glyph.Info.Size.x) / MAtlasSize.x,
+                               (GlyphPos.y + Glyph.Info.Size.y) / MAtlasSize.y);
 
-                            {XPos, YPos + Height, 0.0f, 0.0f},
-                            {XPos + Width, YPos, 1.0f, 1.0f},
-                            {XPos + Width, YPos + Height, 1.0f, 0.0f}};
+  // Overwrites the whole cell so nothing of an evicted glyph remains
+  glState::get().bindTexture(0, GL_TEXTURE_2D, MAtlasTexture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, CellPos.x, CellPos.y, MCellWidth,
+                  MCellHeight, GL_RED, GL_UNSIGNED_BYTE, MCellPixels.data());
+}
+
+textLabel text::createLabel(float X, float Y, float Scale) {
+  MLabels.push_back({X, Y, Scale, std::string(), false, {}, {}, 0, 0});
+  MFirsts.push_back(0);
+  MCounts.push_back(0);
+  MRepack = true;
+  return MLabels.size() - 1;
+}
+
+void text::setLabel(textLabel Label, std::string_view Str) {
+  label &L = MLabels[Label];
+  if (L.Text != Str) {
+    L.Text.assign(Str);
+    L.Dirty = true;
+  }
+}
+
+void text::layoutLabel(label &L) {
+  // Glyphs the label no longer uses may be evicted
+  for (unsigned Cell : L.Cells) {
+    MCells[Cell].Pins--;
+  }
+  L.Cells.clear();
+  L.Vertices.clear();
 
-    // render glyph texture over quad
-    glBindTexture(GL_TEXTURE_2D, I.TextureID);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertices), Vertices);
+  float X = L.X;
+  size_t Pos = 0;
+  while (Pos < L.Text.size()) {
+    const unsigned Cell = getGlyph(decodeUTF8(L.Text, Pos));
+    if (Cell == NumCells) {
+      MStats.Dropped++;
+      continue;
+    }
+    MCells[Cell].Pins++;
+    L.Cells.push_back(Cell);
+
+    float Vertices[6][4];
+    layoutGlyph(MCells[Cell].Info, L.Scale, X, L.Y, Vertices);
+    L.Vertices.insert(L.Vertices.end(), &Vertices[0][0],
+                      &Vertices[0][0] + 6 * 4);
+  }
+  MStats.Relaid++;
+}
+
+void text::draw(GLuint VBO) {
+  MStats = {0, 0, 0, 0, 0, 0};
+  for (size_t i = 0; i < MLabels.size(); i++) {
+    label &L = MLabels[i];
+    if (L.Dirty) {
+      layoutLabel(L);
+      MCounts[i] = L.Vertices.size() / 4;
+      MRepack |= MCounts[i] > L.Capacity;
+    }
+    MStats.Glyphs += MCounts[i] / 6;
+  }
+
+  glState &State = glState::get();
+  State.bindBuffer(GL_ARRAY_BUFFER, VBO);
+  if (MRepack) {
+    // Leave room for labels to grow by half before repacking again
+    GLint First = 0;
+    for (size_t i = 0; i < MLabels.size(); i++) {
+      label &L = MLabels[i];
+      L.First = MFirsts[i] = First;
+      L.Capacity = std::max<GLsizei>(6 * 16, (MCounts[i] * 3 / 2 + 5) / 6 * 6);
+      L.Dirty = true;
+      First += L.Capacity;
+    }
+    const size_t Bytes = First * 4 * sizeof(float);
+    if (Bytes > MVBOBytes) {
+      MVBOBytes = Bytes;
+      glBufferData(GL_ARRAY_BUFFER, MVBOBytes, nullptr, GL_DYNAMIC_DRAW);
+    }
+    MRepack = false;
+  }
+
+  // Only labels whose contents or range changed
+  for (label &L : MLabels) {
+    if (L.Dirty) {
+      const size_t Bytes = L.Vertices.size() * sizeof(float);
+      glBufferSubData(GL_ARRAY_BUFFER, L.First * 4 * sizeof(float), Bytes,
+                      L.Vertices.data());
+      MStats.UploadBytes += Bytes;
+      L.Dirty = false;
+    }
+  }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    // now advance cursors for next glyph (note that advance is number of 1/64
-    // pixels) bitshift by 6 to get value in pixels 2^6 = 64 (divide amount of
-    // 1/64th pixels by 64 to get amount of pixels)
-    X += (I.Advance >> 6) * Scale;
+  if (MStats.Glyphs == 0) {
+    return;
   }
+  State.bindTexture(0, GL_TEXTURE_2D, MAtlasTexture);
+  glMultiDrawArrays(GL_TRIANGLES, MFirsts.data(), MCounts.data(),
+                    MLabels.size());
+  MStats.DrawCalls = 1;
 }
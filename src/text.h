@@ -5,29 +5,136 @@
 #include <GL/glew.h>
 #include <GL/gl.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 // clang-format on
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 struct charInfo {
-  unsigned int TextureID; // ID handle of the glyph texture
-  glm::ivec2 Size;        // Size of glyph
-  glm::ivec2 Bearing;     // Offset from baseline to left/top of glyph
-  unsigned int Advance;   // Horizontal offset to advance to next glyph
+  glm::vec2 UVMin;      // Top left corner of the glyph in the atlas
+  glm::vec2 UVMax;      // Bottom right corner of the glyph in the atlas
+  glm::ivec2 Size;      // Size of glyph
+  glm::ivec2 Bearing;   // Offset from baseline to left/top of glyph
+  unsigned int Advance; // Horizontal offset to advance to next glyph
 };
 
+// Decodes the UTF-8 codepoint starting at Pos in Str and advances Pos past
+// it. Malformed, overlong and surrogate sequences decode to U+FFFD, consuming
+// one byte so decoding resynchronizes on the next.
+char32_t decodeUTF8(const std::string &Str, size_t &Pos);
+
+// Fills Vertices with the two triangles, as (x, y, u, v), of a quad covering
+// glyph Info with its origin at X, Y, then advances X to the next origin.
+// Doesn't touch GL state so can be used without a context.
+void layoutGlyph(const charInfo &Info, float Scale, float &X, float Y,
+                 float (&Vertices)[6][4]);
+
+// Text submitted by the last draw(). Every label is drawn by one draw call,
+// and only labels whose contents changed are uploaded.
+struct textStats {
+  unsigned Glyphs;
+  unsigned DrawCalls;
+  size_t UploadBytes;
+  unsigned Relaid;     // Labels laid out again as their contents changed
+  unsigned Rasterized; // Glyphs missing from the cache
+  unsigned Dropped;    // Glyphs skipped as every cell was in use
+};
+
+// Handle of a string retained by text, from text::createLabel()
+using textLabel = unsigned;
+
+// Glyphs are rasterized the first time they are used into a fixed grid of
+// cells in a single atlas texture, evicting the least recently used glyph
+// once every cell is taken.
+//
+// Strings are retained as labels, each with its own range of the vertex
+// buffer. A label is only laid out and uploaded again when its contents
+// change, and keeps the cells of its glyphs from being evicted.
 struct text {
-  text();
+  // FontData is the contents of a font file FreeType can read
+  explicit text(std::vector<unsigned char> FontData);
   ~text();
 
-  void render(GLuint VBO, std::string Text, float X, float Y, float Scale);
+  // Creates an empty label with its origin at X, Y
+  textLabel createLabel(float X, float Y, float Scale);
+  // Sets the UTF-8 contents of Label, which is laid out again by the next
+  // draw() only if they differ from its current contents
+  void setLabel(textLabel Label, std::string_view Str);
+
+  // Uploads labels changed since the last draw to VBO, which is reallocated
+  // when a label outgrows its range, and draws every label with the atlas
+  // bound to texture unit 0. The text program and a vertex array reading VBO
+  // must already be bound.
+  void draw(GLuint VBO);
+
+  const textStats &getStats() const { return MStats; }
   void freeTextures();
 
+  // Glyphs the atlas can hold at once
+  static constexpr unsigned NumCells = 256;
+
 private:
-  std::unordered_map<GLchar, charInfo> MCharMap;
+  // Cached glyph, or a free cell when Codepoint is NoCodepoint
+  struct glyphCell {
+    char32_t Codepoint;
+    charInfo Info;
+    uint64_t LastUse; // MUseCount when last laid out
+    unsigned Pins;    // Glyphs of labels laid out from the cell
+  };
+  static constexpr char32_t NoCodepoint = ~char32_t(0);
+
+  struct label {
+    float X, Y, Scale;
+    std::string Text;
+    bool Dirty;
+    // Quads as (x, y, u, v), and the cells they sample
+    std::vector<float> Vertices;
+    std::vector<unsigned> Cells;
+    // Range of the vertex buffer, in vertices
+    GLint First;
+    GLsizei Capacity;
+  };
+
+  // Looks up or rasterizes the glyph of Codepoint, returning its cell or
+  // NumCells if every cell is pinned
+  unsigned getGlyph(char32_t Codepoint);
+  unsigned evictCell();
+  void rasterize(char32_t Codepoint, unsigned Cell);
+  void layoutLabel(label &Label);
+
+  std::vector<glyphCell> MCells;
+  // Cell of each ASCII codepoint, or -1, hashing only the rest
+  int MASCIICells[128];
+  std::unordered_map<char32_t, unsigned> MCellMap;
+  unsigned MNumUsedCells;
+  // Increases with every glyph laid out, orders cells by their last use
+  uint64_t MUseCount;
+
+  GLuint MAtlasTexture;
+  unsigned MCellWidth;
+  unsigned MCellHeight;
+  unsigned MAtlasColumns;
+  glm::vec2 MAtlasSize;
+  // Zeroed cell the glyph bitmap is copied into, clearing the evicted glyph
+  std::vector<unsigned char> MCellPixels;
+
+  std::vector<label> MLabels;
+  // First vertex and vertex count of each label for glMultiDrawArrays
+  std::vector<GLint> MFirsts;
+  std::vector<GLsizei> MCounts;
+  // Label ranges must be reassigned and the whole buffer uploaded
+  bool MRepack;
+  // Bytes allocated for the VBO passed to draw()
+  size_t MVBOBytes;
+  textStats MStats;
+
+  // Read by FreeType for as long as MFontFace exists
+  std::vector<unsigned char> MFontData;
   FT_Library MFreeType;
   FT_Face MFontFace;
 };
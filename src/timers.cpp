@@ -0,0 +1,194 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "timers.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+void rollingStats::add(double Sample) {
+  MSamples[MNext] = Sample;
+  MNext = (MNext + 1) % MSamples.size();
+  MCount = std::min(MCount + 1, MSamples.size());
+}
+
+double rollingStats::percentile(double P) const {
+  if (MCount == 0) {
+    return 0.0;
+  }
+
+  MScratch.assign(MSamples.begin(), MSamples.begin() + MCount);
+  // Nearest-rank, 1 based rank converted to an index
+  size_t Rank = static_cast<size_t>(std::ceil((P / 100.0) * MCount));
+  size_t Idx = (Rank == 0) ? 0 : std::min(Rank, MCount) - 1;
+  std::nth_element(MScratch.begin(), MScratch.begin() + Idx, MScratch.end());
+  return MScratch[Idx];
+}
+
+double rollingStats::max() const {
+  if (MCount == 0) {
+    return 0.0;
+  }
+  return *std::max_element(MSamples.begin(), MSamples.begin() + MCount);
+}
+
+frameTimers::frameTimers()
+    : MBuffer(0), MHasFrameStart(false), MNumFrames(0), MNumStalls(0) {
+  for (unsigned B = 0; B < NumBuffers; B++) {
+    glGenQueries(NumPasses, MQueries[B].data());
+    MPending[B].fill(false);
+  }
+}
+
+frameTimers::~frameTimers() { freeQueries(); }
+
+void frameTimers::freeQueries() {
+  for (unsigned B = 0; B < NumBuffers; B++) {
+    if (MQueries[B][0] != 0) {
+      glDeleteQueries(NumPasses, MQueries[B].data());
+      MQueries[B].fill(0);
+    }
+  }
+}
+
+void frameTimers::beginFrame() {
+  auto Now = std::chrono::steady_clock::now();
+  if (MHasFrameStart) {
+    std::chrono::duration<double, std::milli> FrameTime = Now - MFrameStart;
+    MFrameStats.add(FrameTime.count());
+  }
+  MFrameStart = Now;
+  MHasFrameStart = true;
+}
+
+bool frameTimers::collect(unsigned B, bool Wait) {
+  bool Collected = true;
+  for (unsigned P = 0; P < NumPasses; P++) {
+    if (!MPending[B][P]) {
+      continue;
+    }
+    if (!Wait) {
+      GLint Available = GL_FALSE;
+      glGetQueryObjectiv(MQueries[B][P], GL_QUERY_RESULT_AVAILABLE,
+                         &Available);
+      if (Available != GL_TRUE) {
+        Collected = false;
+        continue;
+      }
+    }
+
+    // Blocks until the result is available
+    GLuint64 Nanoseconds = 0;
+    glGetQueryObjectui64v(MQueries[B][P], GL_QUERY_RESULT, &Nanoseconds);
+    MPassStats[P].add(Nanoseconds / 1.0e6);
+    MPending[B][P] = false;
+  }
+  return Collected;
+}
+
+void frameTimers::endFrame() {
+  MNumFrames++;
+
+  // Results complete in order, so stop at the first set still in flight,
+  // starting from the oldest
+  for (unsigned i = 1; i <= NumBuffers; i++) {
+    if (!collect((MBuffer + i) % NumBuffers, false)) {
+      break;
+    }
+  }
+
+  // The next set is the oldest, if it is still in flight the GPU is a whole
+  // ring behind and its results are waited on rather than overwritten
+  MBuffer = (MBuffer + 1) % NumBuffers;
+  if (!collect(MBuffer, false)) {
+    MNumStalls++;
+    collect(MBuffer, true);
+  }
+}
+
+unsigned frameTimers::getNumPending() const {
+  unsigned NumPending = 0;
+  for (const auto &Buffer : MPending) {
+    NumPending += std::count(Buffer.begin(), Buffer.end(), true);
+  }
+  return NumPending;
+}
+
+void frameTimers::beginPass(pass P) {
+  unsigned Idx = static_cast<unsigned>(P);
+  glBeginQuery(GL_TIME_ELAPSED, MQueries[MBuffer][Idx]);
+}
+
+void frameTimers::endPass(pass P) {
+  unsigned Idx = static_cast<unsigned>(P);
+  glEndQuery(GL_TIME_ELAPSED);
+  MPending[MBuffer][Idx] = true;
+}
+
+const char *frameTimers::getPassName(pass P) {
+  switch (P) {
+  case pass::Sphere:
+    return "sphere";
+  case pass::Skybox:
+    return "skybox";
+  case pass::Text:
+    return "text";
+  default:
+    return "unknown";
+  }
+}
+
+namespace {
+std::string formatSummary(const char *Name, const rollingStats &Stats) {
+  std::stringstream sstr;
+  sstr << std::fixed << std::setprecision(2) << Name
+       << " p50 " << Stats.percentile(50) << " p95 " << Stats.percentile(95)
+       << " p99 " << Stats.percentile(99) << " max " << Stats.max() << " ms";
+  return sstr.str();
+}
+
+void writeStatsJSON(std::ofstream &Out, const rollingStats &Stats) {
+  Out << "{\"samples\": " << Stats.size()
+      << ", \"p50\": " << Stats.percentile(50)
+      << ", \"p95\": " << Stats.percentile(95)
+      << ", \"p99\": " << Stats.percentile(99) << ", \"max\": " << Stats.max()
+      << "}";
+}
+} // namespace
+
+std::string frameTimers::getSummaryStr(pass P) const {
+  std::string Name = std::string(getPassName(P)) + " GPU";
+  return formatSummary(Name.c_str(), getPassStats(P));
+}
+
+std::string frameTimers::getFrameSummaryStr() const {
+  return formatSummary("frame CPU", MFrameStats);
+}
+
+void frameTimers::writeJSON(const std::string &Path) const {
+  std::ofstream Out(Path, std::ios::out | std::ios::trunc);
+  if (!Out.is_open()) {
+    throw std::runtime_error(std::string("Could not open stats file ") + Path);
+  }
+
+  Out << std::setprecision(6);
+  Out << "{" << std::endl;
+  Out << "  \"unit\": \"ms\"," << std::endl;
+  Out << "  \"frames\": " << MNumFrames << "," << std::endl;
+  Out << "  \"gpu_stalls\": " << MNumStalls << "," << std::endl;
+  Out << "  \"gpu_samples_dropped\": " << getNumPending() << ","
+      << std::endl;
+  Out << "  \"frame_cpu\": ";
+  writeStatsJSON(Out, MFrameStats);
+  Out << "," << std::endl;
+  Out << "  \"passes_gpu\": {" << std::endl;
+  for (unsigned P = 0; P < NumPasses; P++) {
+    Out << "    \"" << getPassName(static_cast<pass>(P)) << "\": ";
+    writeStatsJSON(Out, MPassStats[P]);
+    Out << ((P + 1 < NumPasses) ? "," : "") << std::endl;
+  }
+  Out << "  }" << std::endl;
+  Out << "}" << std::endl;
+}
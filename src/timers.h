@@ -0,0 +1,97 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+// clang-format off
+#include <GL/glew.h>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+// clang-format on
+
+// Render passes timed individually on the GPU
+enum class pass : unsigned { Sphere, Skybox, Text, Count };
+
+// Fixed size window of the most recent samples, oldest samples are
+// overwritten once the window is full.
+struct rollingStats {
+  explicit rollingStats(size_t Capacity = 1024)
+      : MSamples(Capacity), MNext(0), MCount(0) {}
+
+  void add(double Sample);
+
+  // Nearest-rank percentile of the samples in the window, P in [0, 100]
+  double percentile(double P) const;
+  double max() const;
+  size_t size() const { return MCount; }
+
+private:
+  std::vector<double> MSamples;
+  size_t MNext;
+  size_t MCount;
+
+  // Reused for percentile selection to avoid allocating per query
+  mutable std::vector<double> MScratch;
+};
+
+// Measures GPU time of each render pass with GL_TIME_ELAPSED queries, and the
+// CPU time of each frame. Queries rotate through a ring of sets, and a set
+// stays pending until every result in it is available, so no sample is
+// dropped however far the GPU lags behind. Only when the GPU is a whole ring
+// behind does endFrame() wait on the oldest set, which is counted as a stall.
+struct frameTimers {
+  frameTimers();
+  ~frameTimers();
+
+  // Must bracket every frame, endFrame() collects every available result
+  void beginFrame();
+  void endFrame();
+
+  // Queries can't nest, so passes must not overlap
+  void beginPass(pass P);
+  void endPass(pass P);
+
+  // GPU time of a pass in milliseconds
+  const rollingStats &getPassStats(pass P) const {
+    return MPassStats[static_cast<unsigned>(P)];
+  }
+  // CPU time between the start of consecutive frames, in milliseconds
+  const rollingStats &getFrameStats() const { return MFrameStats; }
+
+  // Frames which waited on a GPU result to reuse its query set
+  unsigned long long getNumStalls() const { return MNumStalls; }
+  // Samples of passes issued but not yet collected, which are missing from
+  // the statistics if they are read now
+  unsigned getNumPending() const;
+
+  // Single line summary of p50/p95/p99/max in milliseconds
+  std::string getSummaryStr(pass P) const;
+  std::string getFrameSummaryStr() const;
+
+  void writeJSON(const std::string &Path) const;
+  void freeQueries();
+
+  static const char *getPassName(pass P);
+
+private:
+  static constexpr unsigned NumPasses = static_cast<unsigned>(pass::Count);
+  // Enough for results to arrive a few frames late without waiting
+  static constexpr unsigned NumBuffers = 4;
+
+  // Adds the available results of buffer B to the statistics, waiting for
+  // them with Wait. Returns whether every result has been collected.
+  bool collect(unsigned B, bool Wait);
+
+  std::array<std::array<GLuint, NumPasses>, NumBuffers> MQueries;
+  // Whether the query was issued and its result not yet collected
+  std::array<std::array<bool, NumPasses>, NumBuffers> MPending;
+  unsigned MBuffer;
+
+  std::array<rollingStats, NumPasses> MPassStats;
+  rollingStats MFrameStats;
+
+  std::chrono::steady_clock::time_point MFrameStart;
+  bool MHasFrameStart;
+  unsigned long long MNumFrames;
+  unsigned long long MNumStalls;
+};
@@ -0,0 +1,99 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+const std::chrono::steady_clock::time_point Epoch =
+    std::chrono::steady_clock::now();
+std::atomic<uint32_t> NextThreadID(1);
+} // namespace
+
+tracer &tracer::get() {
+  static tracer Tracer;
+  return Tracer;
+}
+
+void tracer::enable(size_t Capacity) {
+  MEvents.resize(Capacity);
+  MNext.store(0);
+  MEnabled.store(true);
+}
+
+uint64_t tracer::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - Epoch)
+      .count();
+}
+
+uint32_t tracer::getThreadID() {
+  thread_local uint32_t ThreadID = NextThreadID.fetch_add(1);
+  return ThreadID;
+}
+
+void tracer::record(const char *Name, uint64_t Start, uint64_t End) {
+  // Counted before checking MEnabled, so stop() either sees this call or
+  // this call sees recording stopped
+  MRecording.fetch_add(1);
+  if (MEnabled.load()) {
+    size_t Idx = MNext.fetch_add(1, std::memory_order_relaxed);
+    if (Idx < MEvents.size()) {
+      MEvents[Idx] = {Name, Start, End - Start, getThreadID()};
+    }
+  }
+  MRecording.fetch_sub(1, std::memory_order_release);
+}
+
+void tracer::stop() {
+  MEnabled.store(false);
+  while (MRecording.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+}
+
+void tracer::writeJSON(const std::string &Path) {
+  stop();
+
+  std::ofstream Out(Path, std::ios::out | std::ios::trunc);
+  if (!Out.is_open()) {
+    throw std::runtime_error(std::string("Could not open trace file ") + Path);
+  }
+
+  size_t Recorded = MNext.load();
+  size_t NumEvents = std::min(Recorded, MEvents.size());
+  const int PID = getpid();
+
+  // Trace event timestamps are in microseconds, keep nanosecond precision
+  // with fractional values.
+  Out << std::fixed << std::setprecision(3);
+  Out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << std::endl;
+  for (size_t i = 0; i < NumEvents; i++) {
+    const traceEvent &E = MEvents[i];
+    Out << "{\"name\": \"" << E.Name << "\", \"ph\": \"X\", \"pid\": " << PID
+        << ", \"tid\": " << E.ThreadID << ", \"ts\": " << E.Start / 1000.0
+        << ", \"dur\": " << E.Duration / 1000.0 << "}"
+        << ((i + 1 < NumEvents) ? "," : "") << std::endl;
+  }
+  Out << "], \"otherData\": {\"dropped_events\": "
+      << (Recorded - NumEvents) << "}}" << std::endl;
+}
+
+scopedZone::scopedZone(const char *Name)
+    : MName(Name), MStart(0), MActive(tracer::get().isEnabled()) {
+  if (MActive) {
+    MStart = tracer::now();
+  }
+}
+
+void scopedZone::end() {
+  if (MActive) {
+    tracer::get().record(MName, MStart, tracer::now());
+    MActive = false;
+  }
+}
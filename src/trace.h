@@ -0,0 +1,70 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A completed zone, Name must have static storage duration
+struct traceEvent {
+  const char *Name;
+  uint64_t Start;    // nanoseconds since the tracer epoch
+  uint64_t Duration; // nanoseconds
+  uint32_t ThreadID;
+};
+
+// Process wide recorder of CPU zones, exported in the Chrome trace event
+// format for chrome://tracing or Perfetto. Storage for events is allocated
+// once by enable(), recording is lock free and drops events once full.
+// writeJSON() stops recording first, so threads still running zones can't
+// write events while they are read.
+struct tracer {
+  static tracer &get();
+
+  void enable(size_t Capacity = 1 << 18);
+  bool isEnabled() const { return MEnabled.load(std::memory_order_relaxed); }
+
+  void record(const char *Name, uint64_t Start, uint64_t End);
+  // Stops recording, waiting for any events being recorded, then writes
+  // those recorded
+  void writeJSON(const std::string &Path);
+
+  // Monotonic nanoseconds since the tracer epoch
+  static uint64_t now();
+  // Small sequential ID of the calling thread
+  static uint32_t getThreadID();
+
+private:
+  tracer() : MNext(0), MEnabled(false), MRecording(0) {}
+
+  // Disables recording and waits for record() calls in progress to finish
+  void stop();
+
+  std::vector<traceEvent> MEvents;
+  std::atomic<size_t> MNext;
+  std::atomic<bool> MEnabled;
+  // Threads inside record()
+  std::atomic<unsigned> MRecording;
+};
+
+// Records the lifetime of the object as a zone, or until end() is called
+struct scopedZone {
+  explicit scopedZone(const char *Name);
+  ~scopedZone() { end(); }
+
+  scopedZone(const scopedZone &) = delete;
+  scopedZone &operator=(const scopedZone &) = delete;
+
+  void end();
+
+private:
+  const char *MName;
+  uint64_t MStart;
+  bool MActive;
+};
+
+#define TRACE_CONCAT_IMPL(A, B) A##B
+#define TRACE_CONCAT(A, B) TRACE_CONCAT_IMPL(A, B)
+// Traces the enclosing scope, Name must be a string literal
+#define TRACE_ZONE(Name) scopedZone TRACE_CONCAT(TraceZone, __LINE__)(Name)
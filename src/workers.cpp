@@ -0,0 +1,89 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+#include "workers.h"
+#include <algorithm>
+
+workerPool::workerPool(unsigned NumThreads)
+    : MTask(nullptr), MContext(nullptr), MCount(0), MChunk(0), MGeneration(0),
+      MPending(0), MStop(false) {
+  if (NumThreads == 0) {
+    NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  MWorkers.reserve(NumThreads - 1);
+  for (unsigned T = 1; T < NumThreads; T++) {
+    MWorkers.emplace_back(&workerPool::workerLoop, this, T);
+  }
+}
+
+workerPool::~workerPool() {
+  {
+    std::lock_guard<std::mutex> Lock(MMutex);
+    MStop = true;
+  }
+  MWake.notify_all();
+  for (auto &Worker : MWorkers) {
+    Worker.join();
+  }
+}
+
+void workerPool::runTask(size_t Count, size_t MinPerThread, taskFn Task,
+                         void *Context) {
+  size_t NumThreads = getNumThreads();
+  NumThreads = std::min(NumThreads, Count / std::max<size_t>(MinPerThread, 1));
+  if (NumThreads <= 1) {
+    Task(Context, 0, Count);
+    return;
+  }
+
+  const size_t Chunk = (Count + NumThreads - 1) / NumThreads;
+  {
+    std::lock_guard<std::mutex> Lock(MMutex);
+    MTask = Task;
+    MContext = Context;
+    MCount = Count;
+    MChunk = Chunk;
+    MPending = MWorkers.size();
+    MGeneration++;
+  }
+  MWake.notify_all();
+
+  // Calling thread takes the first range, workers whose range starts past
+  // Count have nothing to do
+  Task(Context, 0, std::min(Chunk, Count));
+
+  std::unique_lock<std::mutex> Lock(MMutex);
+  MDone.wait(Lock, [this]() { return MPending == 0; });
+  MTask = nullptr;
+  MContext = nullptr;
+}
+
+void workerPool::workerLoop(unsigned Index) {
+  unsigned SeenGeneration = 0;
+  while (true) {
+    taskFn Task;
+    void *Context;
+    size_t Begin, End;
+    {
+      std::unique_lock<std::mutex> Lock(MMutex);
+      MWake.wait(Lock,
+                 [&]() { return MStop || MGeneration != SeenGeneration; });
+      if (MStop) {
+        return;
+      }
+      SeenGeneration = MGeneration;
+      Task = MTask;
+      Context = MContext;
+      Begin = std::min(Index * MChunk, MCount);
+      End = std::min(Begin + MChunk, MCount);
+    }
+
+    if (Begin < End) {
+      Task(Context, Begin, End);
+    }
+
+    std::lock_guard<std::mutex> Lock(MMutex);
+    if (--MPending == 0) {
+      MDone.notify_one();
+    }
+  }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent threads for work issued every frame, where parallelFor() would
+// pay to create and join threads each time. The calling thread runs a share
+// of the work too, so a pool of one thread starts no workers.
+struct workerPool {
+  // NumThreads of 0 uses one thread per hardware thread
+  explicit workerPool(unsigned NumThreads = 0);
+  ~workerPool();
+
+  workerPool(const workerPool &) = delete;
+  workerPool &operator=(const workerPool &) = delete;
+
+  // Calls Func(Begin, End) over contiguous ranges that partition [0, Count)
+  // and returns once all have finished. Ranges are at least MinPerThread long
+  // as with parallelFor(). Func is called through a pointer rather than
+  // copied, so issuing work never allocates.
+  template <typename Fn>
+  void run(size_t Count, size_t MinPerThread, Fn &&Func) {
+    using fnType = std::remove_reference_t<Fn>;
+    runTask(
+        Count, MinPerThread,
+        [](void *Context, size_t Begin, size_t End) {
+          (*static_cast<fnType *>(Context))(Begin, End);
+        },
+        const_cast<void *>(static_cast<const void *>(&Func)));
+  }
+
+  unsigned getNumThreads() const { return MWorkers.size() + 1; }
+
+private:
+  using taskFn = void (*)(void *Context, size_t Begin, size_t End);
+
+  void runTask(size_t Count, size_t MinPerThread, taskFn Task, void *Context);
+  void workerLoop(unsigned Index);
+
+  std::vector<std::thread> MWorkers;
+  std::mutex MMutex;
+  std::condition_variable MWake;
+  std::condition_variable MDone;
+
+  // Job of the current generation, guarded by MMutex
+  taskFn MTask;
+  void *MContext;
+  size_t MCount;
+  size_t MChunk;
+  unsigned MGeneration;
+  unsigned MPending; // Workers yet to finish the current generation
+  bool MStop;
+};
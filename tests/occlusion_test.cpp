@@ -0,0 +1,112 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+// Headless checks of occlusionCuller, which runs entirely on the CPU so needs
+// no GL context. Returns non-zero if any check fails.
+
+// clang-format off
+#include "occlusion.h"
+#include "workers.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <vector>
+// clang-format on
+
+namespace {
+unsigned NumFailed = 0;
+
+void check(bool Condition, const char *Name) {
+  std::cout << (Condition ? "PASS " : "FAIL ") << Name << std::endl;
+  NumFailed += !Condition;
+}
+
+// Camera at the origin looking down -z, as view space
+glm::mat4 getProjection() {
+  return glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+}
+
+ballInstance makeBall(float X, float Y, float Z, float Scale) {
+  return {{X, Y, Z, Scale}, {255, 255, 255, 255}};
+}
+
+void testEmpty() {
+  occlusionCuller Culler(64, 48);
+  Culler.setProjection(getProjection());
+  Culler.clear();
+  bool AllFar = true;
+  for (unsigned Y = 0; Y < Culler.getHeight(); Y++) {
+    for (unsigned X = 0; X < Culler.getWidth(); X++) {
+      AllFar &= Culler.getDepth(X, Y) == FLT_MAX;
+    }
+  }
+  check(AllFar, "empty buffer has depth FLT_MAX everywhere");
+  check(!Culler.isOccluded(glm::vec3(0.0f, 0.0f, -50.0f), 0.5f),
+        "empty buffer hides nothing");
+
+  // No balls are occluders either, so cull() keeps every one
+  std::vector<ballInstance> Balls = {makeBall(0.0f, 0.0f, -10.0f, 1.0f),
+                                     makeBall(3.0f, 0.0f, -20.0f, 1.0f)};
+  std::vector<ballInstance> Out(Balls.size());
+  workerPool Pool(1);
+  occlusionCuller Empty(64, 48, 0);
+  const size_t NumVisible =
+      Empty.cull(Balls.data(), Balls.size(), 1.0f, glm::mat4(1.0f),
+                 getProjection(), Pool, Out.data());
+  check(NumVisible == Balls.size(), "no occluders culls nothing");
+}
+
+void testHidden() {
+  occlusionCuller Culler(64, 48);
+  Culler.setProjection(getProjection());
+  Culler.clear();
+  check(Culler.addOccluder(glm::vec3(0.0f, 0.0f, -3.0f), 1.0f),
+        "near ball is an occluder");
+  check(Culler.getDepth(Culler.getWidth() / 2, Culler.getHeight() / 2) <
+            FLT_MAX,
+        "occluder writes depth at the centre");
+  check(Culler.isOccluded(glm::vec3(0.0f, 0.0f, -20.0f), 0.5f),
+        "ball fully behind the occluder is hidden");
+  check(!Culler.isOccluded(glm::vec3(0.0f, 0.0f, -10.0f), 3.0f),
+        "ball wider than the occluder is kept");
+  // Straddles the edge of the square inscribed in the occluder
+  check(!Culler.isOccluded(glm::vec3(4.7f, 0.0f, -20.0f), 0.5f),
+        "ball partly uncovered is kept");
+  check(Culler.isOccluded(glm::vec3(3.5f, 0.0f, -20.0f), 0.5f),
+        "ball inside the edge of the occluder is hidden");
+  check(!Culler.isOccluded(glm::vec3(0.0f, 0.0f, -2.5f), 2.5f),
+        "ball crossing the near plane is kept");
+}
+
+void testCull() {
+  // One ball in front of another, and one at the same depth straddling the
+  // edge of the square the occluder writes, so only partly behind it
+  std::vector<ballInstance> Balls = {makeBall(0.0f, 0.0f, -20.0f, 0.5f),
+                                     makeBall(0.0f, 0.0f, -3.0f, 1.0f),
+                                     makeBall(4.7f, 0.0f, -20.0f, 0.5f)};
+  std::vector<ballInstance> Out(Balls.size());
+  workerPool Pool(2);
+  occlusionCuller Culler(64, 48);
+  const size_t NumVisible =
+      Culler.cull(Balls.data(), Balls.size(), 1.0f, glm::mat4(1.0f),
+                  getProjection(), Pool, Out.data());
+  check(NumVisible == 2, "cull() hides only the ball behind the occluder");
+  check(NumVisible == 2 && Out[0].OffsetScale[2] == -3.0f &&
+            Out[1].OffsetScale[0] == 4.7f,
+        "cull() preserves the order of the visible balls");
+}
+} // namespace
+
+int main() {
+  testEmpty();
+  testHidden();
+  testCull();
+  if (NumFailed) {
+    std::cout << NumFailed << " checks failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,326 @@
+// Copyright (c) 2025-2026 Ewan Crawford
+
+// Offline tool cooking texture sources into the container glsphere maps at
+// startup, see cooked.h. Every mip level is computed here, and stored both
+// BC1 compressed and as uncompressed RGBA8 for drivers without S3TC.
+
+// clang-format off
+#include "cooked.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+// clang-format on
+
+namespace {
+// RGBA8 pixels of one face of one level
+struct level {
+  unsigned Width;
+  unsigned Height;
+  std::vector<uint8_t> Pixels;
+};
+
+// Averages each 2x2 texel square of Src, a dimension of 1 stays 1
+level downsample(const level &Src) {
+  level Dst;
+  Dst.Width = std::max(Src.Width / 2, 1u);
+  Dst.Height = std::max(Src.Height / 2, 1u);
+  Dst.Pixels.resize(size_t(Dst.Width) * Dst.Height * 4);
+  for (unsigned Y = 0; Y < Dst.Height; Y++) {
+    const unsigned Y0 = std::min(Y * 2, Src.Height - 1);
+    const unsigned Y1 = std::min(Y * 2 + 1, Src.Height - 1);
+    for (unsigned X = 0; X < Dst.Width; X++) {
+      const unsigned X0 = std::min(X * 2, Src.Width - 1);
+      const unsigned X1 = std::min(X * 2 + 1, Src.Width - 1);
+      for (unsigned C = 0; C < 4; C++) {
+        auto at = [&](unsigned SX, unsigned SY) {
+          return unsigned(Src.Pixels[(size_t(SY) * Src.Width + SX) * 4 + C]);
+        };
+        const unsigned Sum = at(X0, Y0) + at(X1, Y0) + at(X0, Y1) + at(X1, Y1);
+        Dst.Pixels[(size_t(Y) * Dst.Width + X) * 4 + C] = (Sum + 2) / 4;
+      }
+    }
+  }
+  return Dst;
+}
+
+uint16_t packRGB565(const float (&Color)[3]) {
+  auto quantize = [](float V, unsigned Max) {
+    return unsigned(std::clamp(V, 0.0f, 255.0f) * Max / 255.0f + 0.5f);
+  };
+  return (quantize(Color[0], 31) << 11) | (quantize(Color[1], 63) << 5) |
+         quantize(Color[2], 31);
+}
+
+void unpackRGB565(uint16_t Packed, int (&Color)[3]) {
+  const int R = (Packed >> 11) & 31, G = (Packed >> 5) & 63, B = Packed & 31;
+  Color[0] = (R << 3) | (R >> 2);
+  Color[1] = (G << 2) | (G >> 4);
+  Color[2] = (B << 3) | (B >> 2);
+}
+
+// Encodes 16 RGB texels as an opaque BC1 block. The endpoints are the
+// extremes of the texels projected onto the axis of greatest variance.
+void encodeBC1Block(const uint8_t (&Texels)[16][3], uint8_t *Block) {
+  float Mean[3] = {0, 0, 0};
+  for (const auto &T : Texels) {
+    for (unsigned C = 0; C < 3; C++) {
+      Mean[C] += T[C] / 16.0f;
+    }
+  }
+  float Cov[6] = {0, 0, 0, 0, 0, 0}; // rr, rg, rb, gg, gb, bb
+  for (const auto &T : Texels) {
+    const float R = T[0] - Mean[0], G = T[1] - Mean[1], B = T[2] - Mean[2];
+    Cov[0] += R * R;
+    Cov[1] += R * G;
+    Cov[2] += R * B;
+    Cov[3] += G * G;
+    Cov[4] += G * B;
+    Cov[5] += B * B;
+  }
+  // Power iteration from the luminance axis
+  float Axis[3] = {0.3f, 0.6f, 0.1f};
+  for (unsigned Iter = 0; Iter < 8; Iter++) {
+    const float Next[3] = {
+        Cov[0] * Axis[0] + Cov[1] * Axis[1] + Cov[2] * Axis[2],
+        Cov[1] * Axis[0] + Cov[3] * Axis[1] + Cov[4] * Axis[2],
+        Cov[2] * Axis[0] + Cov[4] * Axis[1] + Cov[5] * Axis[2]};
+    const float Length = std::max(
+        {std::abs(Next[0]), std::abs(Next[1]), std::abs(Next[2])});
+    if (Length < 1e-6f) {
+      break; // Flat block, any axis will do
+    }
+    for (unsigned C = 0; C < 3; C++) {
+      Axis[C] = Next[C] / Length;
+    }
+  }
+
+  float MinDot = 1e30f, MaxDot = -1e30f;
+  for (const auto &T : Texels) {
+    const float Dot = (T[0] - Mean[0]) * Axis[0] +
+                      (T[1] - Mean[1]) * Axis[1] + (T[2] - Mean[2]) * Axis[2];
+    MinDot = std::min(MinDot, Dot);
+    MaxDot = std::max(MaxDot, Dot);
+  }
+  const float AxisLength2 =
+      Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2];
+  float High[3], Low[3];
+  for (unsigned C = 0; C < 3; C++) {
+    High[C] = Mean[C] + Axis[C] * MaxDot / AxisLength2;
+    Low[C] = Mean[C] + Axis[C] * MinDot / AxisLength2;
+  }
+
+  uint16_t Color0 = packRGB565(High), Color1 = packRGB565(Low);
+  // Color0 > Color1 selects the four colour, opaque mode
+  if (Color0 < Color1) {
+    std::swap(Color0, Color1);
+  }
+  uint32_t Indices = 0;
+  if (Color0 != Color1) {
+    int Palette[4][3];
+    unpackRGB565(Color0, Palette[0]);
+    unpackRGB565(Color1, Palette[1]);
+    for (unsigned C = 0; C < 3; C++) {
+      Palette[2][C] = (2 * Palette[0][C] + Palette[1][C]) / 3;
+      Palette[3][C] = (Palette[0][C] + 2 * Palette[1][C]) / 3;
+    }
+    for (unsigned i = 0; i < 16; i++) {
+      unsigned Best = 0;
+      int BestError = INT32_MAX;
+      for (unsigned P = 0; P < 4; P++) {
+        int Error = 0;
+        for (unsigned C = 0; C < 3; C++) {
+          const int D = int(Texels[i][C]) - Palette[P][C];
+          Error += D * D;
+        }
+        if (Error < BestError) {
+          BestError = Error;
+          Best = P;
+        }
+      }
+      Indices |= Best << (2 * i);
+    }
+  }
+
+  // Little endian
+  Block[0] = Color0 & 0xFF;
+  Block[1] = Color0 >> 8;
+  Block[2] = Color1 & 0xFF;
+  Block[3] = Color1 >> 8;
+  for (unsigned i = 0; i < 4; i++) {
+    Block[4 + i] = (Indices >> (8 * i)) & 0xFF;
+  }
+}
+
+// Texels past the edge of a level smaller than a block repeat the last row
+// or column
+std::vector<uint8_t> encodeBC1(const level &Level) {
+  const unsigned BlocksX = (Level.Width + 3) / 4;
+  const unsigned BlocksY = (Level.Height + 3) / 4;
+  std::vector<uint8_t> Blocks(size_t(BlocksX) * BlocksY * 8);
+  for (unsigned BY = 0; BY < BlocksY; BY++) {
+    for (unsigned BX = 0; BX < BlocksX; BX++) {
+      uint8_t Texels[16][3];
+      for (unsigned i = 0; i < 16; i++) {
+        const unsigned X = std::min(BX * 4 + i % 4, Level.Width - 1);
+        const unsigned Y = std::min(BY * 4 + i / 4, Level.Height - 1);
+        std::memcpy(Texels[i],
+                    &Level.Pixels[(size_t(Y) * Level.Width + X) * 4], 3);
+      }
+      encodeBC1Block(Texels, &Blocks[(size_t(BY) * BlocksX + BX) * 8]);
+    }
+  }
+  return Blocks;
+}
+
+bool isOpaque(const level &Level) {
+  for (size_t i = 3; i < Level.Pixels.size(); i += 4) {
+    if (Level.Pixels[i] != 255) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void printUsage(std::string Name) {
+  std::cerr << "Usage: " << Name << " [--no-bc1] OUTPUT INPUT..." << std::endl
+            << "Cooks one image into a 2D texture, or six into a cubemap in "
+            << "+X, -X, +Y, -Y, +Z, -Z order." << std::endl
+            << "Options:" << std::endl
+            << "\t-h, --help\t\tShow this help message" << std::endl
+            << "\t--no-bc1 \t\tOnly store uncompressed RGBA8 levels"
+            << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool BC1 = true;
+  std::vector<std::string> Paths;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      printUsage(argv[0]);
+      return 0;
+    } else if (arg == "--no-bc1") {
+      BC1 = false;
+    } else {
+      Paths.push_back(arg);
+    }
+  }
+  if (Paths.size() != 2 && Paths.size() != 7) {
+    printUsage(argv[0]);
+    return -1;
+  }
+  const std::string OutputPath = Paths.front();
+  Paths.erase(Paths.begin());
+
+  try {
+    // Mip chain of each face
+    std::vector<std::vector<level>> Faces;
+    for (const std::string &Path : Paths) {
+      int Width, Height, Channels;
+      unsigned char *Data = stbi_load(Path.c_str(), &Width, &Height, &Channels,
+                                      4 /* always RGBA */);
+      if (!Data) {
+        throw std::runtime_error(
+            std::string("Texture failed to load at path: ") + Path);
+      }
+      level Base{unsigned(Width), unsigned(Height),
+                 std::vector<uint8_t>(Data, Data + size_t(Width) * Height * 4)};
+      stbi_image_free(Data);
+      if (!Faces.empty() && (Base.Width != Faces[0][0].Width ||
+                             Base.Height != Faces[0][0].Height)) {
+        throw std::runtime_error(std::string("Faces differ in size: ") + Path);
+      }
+
+      std::vector<level> Levels;
+      Levels.push_back(std::move(Base));
+      while (Levels.back().Width > 1 || Levels.back().Height > 1) {
+        Levels.push_back(downsample(Levels.back()));
+      }
+      Faces.push_back(std::move(Levels));
+    }
+
+    // BC1 would lose any alpha, which the shaders don't read anyway but may
+    // be wanted later
+    for (const auto &Face : Faces) {
+      BC1 = BC1 && isOpaque(Face[0]);
+    }
+
+    cookedHeader Header;
+    std::memcpy(Header.Magic, CookedMagic, sizeof(CookedMagic));
+    Header.Faces = Faces.size();
+    Header.Width = Faces[0][0].Width;
+    Header.Height = Faces[0][0].Height;
+    Header.Levels = Faces[0].size();
+    Header.NumEncodings = BC1 ? 2 : 1;
+
+    // Data of each encoding, level by level then face by face
+    std::vector<std::vector<uint8_t>> Data;
+    std::vector<cookedEncoding> Encodings;
+    for (GLenum Format : {CookedBC1, CookedRGBA8}) {
+      if (Format == CookedBC1 && !BC1) {
+        continue;
+      }
+      std::vector<uint8_t> Encoded;
+      for (unsigned L = 0; L < Header.Levels; L++) {
+        for (const auto &Face : Faces) {
+          const std::vector<uint8_t> Level =
+              Format == CookedBC1 ? encodeBC1(Face[L]) : Face[L].Pixels;
+          Encoded.insert(Encoded.end(), Level.begin(), Level.end());
+        }
+      }
+      Encodings.push_back({Format, 0, 0, Encoded.size()});
+      Data.push_back(std::move(Encoded));
+    }
+
+    // Data starts 16 byte aligned
+    uint64_t Offset = sizeof(cookedHeader) +
+                      Encodings.size() * sizeof(cookedEncoding);
+    for (cookedEncoding &Encoding : Encodings) {
+      Offset = (Offset + 15) & ~uint64_t(15);
+      Encoding.Offset = Offset;
+      Offset += Encoding.Size;
+    }
+
+    std::ofstream File(OutputPath, std::ios::binary | std::ios::trunc);
+    if (!File.is_open()) {
+      throw std::runtime_error(std::string("Could not open output file ") +
+                               OutputPath);
+    }
+    File.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+    File.write(reinterpret_cast<const char *>(Encodings.data()),
+               Encodings.size() * sizeof(cookedEncoding));
+    for (size_t E = 0; E < Encodings.size(); E++) {
+      const std::vector<char> Padding(Encodings[E].Offset - File.tellp(), 0);
+      File.write(Padding.data(), Padding.size());
+      File.write(reinterpret_cast<const char *>(Data[E].data()),
+                 Data[E].size());
+    }
+    if (!File) {
+      throw std::runtime_error(std::string("Could not write output file ") +
+                               OutputPath);
+    }
+
+    std::cout << OutputPath << ": " << Header.Width << "x" << Header.Height
+              << ", " << Header.Faces << " faces, " << Header.Levels
+              << " levels";
+    for (const cookedEncoding &Encoding : Encodings) {
+      std::cout << ", " << (Encoding.Format == CookedBC1 ? "BC1 " : "RGBA8 ")
+                << Encoding.Size << " bytes";
+    }
+    std::cout << std::endl;
+  } catch (std::exception &E) {
+    std::cerr << "Error " << E.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}